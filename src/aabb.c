@@ -0,0 +1,111 @@
+#include "aabb.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(AABB_HAVE_AVX2)
+#include <immintrin.h>
+#endif
+
+int aabb_overlap_scalar(int minX, int minY, int maxX, int maxY,
+                        const int *boxMinX, const int *boxMinY,
+                        const int *boxMaxX, const int *boxMaxY, int n,
+                        uint32_t *hits) {
+  int count = 0;
+  memset(hits, 0, AABB_MASK_WORDS(n) * sizeof(uint32_t));
+  for (int i = 0; i < n; i++) {
+    // non-short-circuit so the compiler is free to vectorise the loop
+    int hit = (minX < boxMaxX[i]) & (maxX > boxMinX[i]) &
+              (minY < boxMaxY[i]) & (maxY > boxMinY[i]);
+    hits[i >> 5] |= (uint32_t)hit << (i & 31);
+    count += hit;
+  }
+  return count;
+}
+
+#if defined(__SSE2__)
+int aabb_overlap_sse2(int minX, int minY, int maxX, int maxY,
+                      const int *boxMinX, const int *boxMinY,
+                      const int *boxMaxX, const int *boxMaxY, int n,
+                      uint32_t *hits) {
+  __m128i qMinX = _mm_set1_epi32(minX);
+  __m128i qMinY = _mm_set1_epi32(minY);
+  __m128i qMaxX = _mm_set1_epi32(maxX);
+  __m128i qMaxY = _mm_set1_epi32(maxY);
+  int count = 0;
+  int i = 0;
+  memset(hits, 0, AABB_MASK_WORDS(n) * sizeof(uint32_t));
+  for (; i + 4 <= n; i += 4) {
+    __m128i bMinX = _mm_loadu_si128((const __m128i *)&boxMinX[i]);
+    __m128i bMinY = _mm_loadu_si128((const __m128i *)&boxMinY[i]);
+    __m128i bMaxX = _mm_loadu_si128((const __m128i *)&boxMaxX[i]);
+    __m128i bMaxY = _mm_loadu_si128((const __m128i *)&boxMaxY[i]);
+    __m128i m = _mm_and_si128(_mm_cmplt_epi32(qMinX, bMaxX),
+                              _mm_cmpgt_epi32(qMaxX, bMinX));
+    m = _mm_and_si128(m, _mm_cmplt_epi32(qMinY, bMaxY));
+    m = _mm_and_si128(m, _mm_cmpgt_epi32(qMaxY, bMinY));
+    uint32_t bits = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(m));
+    hits[i >> 5] |= bits << (i & 31);
+    count += __builtin_popcount(bits);
+  }
+  for (; i < n; i++) {
+    int hit = (minX < boxMaxX[i]) & (maxX > boxMinX[i]) &
+              (minY < boxMaxY[i]) & (maxY > boxMinY[i]);
+    hits[i >> 5] |= (uint32_t)hit << (i & 31);
+    count += hit;
+  }
+  return count;
+}
+#endif
+
+#if defined(AABB_HAVE_AVX2)
+__attribute__((target("avx2"))) int
+aabb_overlap_avx2(int minX, int minY, int maxX, int maxY, const int *boxMinX,
+                  const int *boxMinY, const int *boxMaxX, const int *boxMaxY,
+                  int n, uint32_t *hits) {
+  __m256i qMinX = _mm256_set1_epi32(minX);
+  __m256i qMinY = _mm256_set1_epi32(minY);
+  __m256i qMaxX = _mm256_set1_epi32(maxX);
+  __m256i qMaxY = _mm256_set1_epi32(maxY);
+  int count = 0;
+  int i = 0;
+  memset(hits, 0, AABB_MASK_WORDS(n) * sizeof(uint32_t));
+  for (; i + 8 <= n; i += 8) {
+    __m256i bMinX = _mm256_loadu_si256((const __m256i *)&boxMinX[i]);
+    __m256i bMinY = _mm256_loadu_si256((const __m256i *)&boxMinY[i]);
+    __m256i bMaxX = _mm256_loadu_si256((const __m256i *)&boxMaxX[i]);
+    __m256i bMaxY = _mm256_loadu_si256((const __m256i *)&boxMaxY[i]);
+    // a < b is b > a; AVX2 only has the greater-than compare
+    __m256i m = _mm256_and_si256(_mm256_cmpgt_epi32(bMaxX, qMinX),
+                                 _mm256_cmpgt_epi32(qMaxX, bMinX));
+    m = _mm256_and_si256(m, _mm256_cmpgt_epi32(bMaxY, qMinY));
+    m = _mm256_and_si256(m, _mm256_cmpgt_epi32(qMaxY, bMinY));
+    uint32_t bits = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(m));
+    hits[i >> 5] |= bits << (i & 31);
+    count += __builtin_popcount(bits);
+  }
+  for (; i < n; i++) {
+    int hit = (minX < boxMaxX[i]) & (maxX > boxMinX[i]) &
+              (minY < boxMaxY[i]) & (maxY > boxMinY[i]);
+    hits[i >> 5] |= (uint32_t)hit << (i & 31);
+    count += hit;
+  }
+  return count;
+}
+#endif
+
+int aabb_overlap(int minX, int minY, int maxX, int maxY, const int *boxMinX,
+                 const int *boxMinY, const int *boxMaxX, const int *boxMaxY,
+                 int n, uint32_t *hits) {
+#if defined(AABB_HAVE_AVX2)
+  if (__builtin_cpu_supports("avx2")) {
+    return aabb_overlap_avx2(minX, minY, maxX, maxY, boxMinX, boxMinY, boxMaxX,
+                             boxMaxY, n, hits);
+  }
+#endif
+#if defined(__SSE2__)
+  return aabb_overlap_sse2(minX, minY, maxX, maxY, boxMinX, boxMinY, boxMaxX,
+                           boxMaxY, n, hits);
+#else
+  return aabb_overlap_scalar(minX, minY, maxX, maxY, boxMinX, boxMinY, boxMaxX,
+                             boxMaxY, n, hits);
+#endif
+}
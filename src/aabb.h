@@ -0,0 +1,46 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include <stdint.h>
+
+// Batched axis-aligned box overlap tests. Boxes are given as packed arrays of
+// integer edges, min inclusive and max exclusive, so a sprite at (x, y) with
+// size (w, h) is {x, y, x + w, y + h}. The overlap rule matches raylib's
+// CheckCollisionRecs: touching edges do not collide.
+
+// Number of 32-bit words needed for a hit mask over n boxes.
+#define AABB_MASK_WORDS(n) (((n) + 31) / 32)
+
+// Test the query box against boxes[0..n) and set bit i of hits (bit i % 32 of
+// word i / 32) for every box i it overlaps. hits must hold AABB_MASK_WORDS(n)
+// words. Returns the number of overlaps.
+typedef int (*AabbOverlapFn)(int minX, int minY, int maxX, int maxY,
+                             const int *boxMinX, const int *boxMinY,
+                             const int *boxMaxX, const int *boxMaxY, int n,
+                             uint32_t *hits);
+
+int aabb_overlap_scalar(int minX, int minY, int maxX, int maxY,
+                        const int *boxMinX, const int *boxMinY,
+                        const int *boxMaxX, const int *boxMaxY, int n,
+                        uint32_t *hits);
+#if defined(__SSE2__)
+int aabb_overlap_sse2(int minX, int minY, int maxX, int maxY,
+                      const int *boxMinX, const int *boxMinY,
+                      const int *boxMaxX, const int *boxMaxY, int n,
+                      uint32_t *hits);
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AABB_HAVE_AVX2
+int aabb_overlap_avx2(int minX, int minY, int maxX, int maxY,
+                      const int *boxMinX, const int *boxMinY,
+                      const int *boxMaxX, const int *boxMaxY, int n,
+                      uint32_t *hits);
+#endif
+
+// Best kernel for the running CPU: AVX2 when available, then SSE2, then the
+// scalar loop.
+int aabb_overlap(int minX, int minY, int maxX, int maxY, const int *boxMinX,
+                 const int *boxMinY, const int *boxMaxX, const int *boxMaxY,
+                 int n, uint32_t *hits);
+
+#endif
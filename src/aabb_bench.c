@@ -0,0 +1,116 @@
+// Micro-benchmark for the batched AABB kernels in aabb.c. Each kernel tests
+// one shark-sized box against N packed boxes spread over the playfield and is
+// compared with the per-pair Rectangle path the game used before.
+#include "aabb.h"
+#include "raylib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SCREEN_WIDTH 640
+#define SCREEN_HEIGHT 960
+#define ITERATIONS 20000
+
+// Same test as CheckCollisionRecs in raylib/src/rshapes.c, copied so the
+// benchmark does not need a window or the raylib library.
+static bool recs_overlap(Rectangle rec1, Rectangle rec2) {
+  return (rec1.x < (rec2.x + rec2.width) && (rec1.x + rec1.width) > rec2.x) &&
+         (rec1.y < (rec2.y + rec2.height) && (rec1.y + rec1.height) > rec2.y);
+}
+
+static int rectangle_path(int minX, int minY, int maxX, int maxY,
+                          const int *boxMinX, const int *boxMinY,
+                          const int *boxMaxX, const int *boxMaxY, int n,
+                          uint32_t *hits) {
+  Rectangle query = {minX, minY, maxX - minX, maxY - minY};
+  int count = 0;
+  for (int i = 0; i < AABB_MASK_WORDS(n); i++) {
+    hits[i] = 0;
+  }
+  for (int i = 0; i < n; i++) {
+    Rectangle box = {boxMinX[i], boxMinY[i], boxMaxX[i] - boxMinX[i],
+                     boxMaxY[i] - boxMinY[i]};
+    if (recs_overlap(query, box)) {
+      hits[i >> 5] |= 1u << (i & 31);
+      count++;
+    }
+  }
+  return count;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef struct {
+  const char *name;
+  AabbOverlapFn fn;
+} Kernel;
+
+static void run(int n, const Kernel *kernels, int kernelCount) {
+  int *minX = malloc(n * sizeof(int));
+  int *minY = malloc(n * sizeof(int));
+  int *maxX = malloc(n * sizeof(int));
+  int *maxY = malloc(n * sizeof(int));
+  uint32_t *hits = malloc(AABB_MASK_WORDS(n) * sizeof(uint32_t));
+  uint32_t *expected = malloc(AABB_MASK_WORDS(n) * sizeof(uint32_t));
+  srand(n);
+  for (int i = 0; i < n; i++) {
+    minX[i] = rand() % SCREEN_WIDTH;
+    minY[i] = rand() % (SCREEN_HEIGHT + 64) - 64;
+    maxX[i] = minX[i] + 15 + rand() % 86;
+    maxY[i] = minY[i] + 15 + rand() % 50;
+  }
+  // the shark's box near the bottom of the screen
+  int qx = SCREEN_WIDTH / 2 - 15, qy = SCREEN_HEIGHT - 100;
+  rectangle_path(qx, qy, qx + 30, qy + 80, minX, minY, maxX, maxY, n,
+                 expected);
+
+  for (int k = 0; k < kernelCount; k++) {
+    volatile int sink = 0;
+    double start = now_ns();
+    for (int it = 0; it < ITERATIONS; it++) {
+      // nudge the query so the calls cannot be hoisted out of the loop
+      int dx = it & 7;
+      sink += kernels[k].fn(qx + dx, qy, qx + dx + 30, qy + 80, minX, minY,
+                            maxX, maxY, n, hits);
+    }
+    double perCall = (now_ns() - start) / ITERATIONS;
+    kernels[k].fn(qx, qy, qx + 30, qy + 80, minX, minY, maxX, maxY, n, hits);
+    bool match = true;
+    for (int w = 0; w < AABB_MASK_WORDS(n); w++) {
+      match = match && hits[w] == expected[w];
+    }
+    printf("%6d  %-10s %10.1f ns/call %8.2f ns/box  %s\n", n, kernels[k].name,
+           perCall, perCall / n, match ? "ok" : "MISMATCH");
+  }
+
+  free(minX);
+  free(minY);
+  free(maxX);
+  free(maxY);
+  free(hits);
+  free(expected);
+}
+
+int main() {
+  Kernel kernels[4];
+  int kernelCount = 0;
+  kernels[kernelCount++] = (Kernel){"rectangle", rectangle_path};
+  kernels[kernelCount++] = (Kernel){"scalar", aabb_overlap_scalar};
+#if defined(__SSE2__)
+  kernels[kernelCount++] = (Kernel){"sse2", aabb_overlap_sse2};
+#endif
+#if defined(AABB_HAVE_AVX2)
+  if (__builtin_cpu_supports("avx2")) {
+    kernels[kernelCount++] = (Kernel){"avx2", aabb_overlap_avx2};
+  }
+#endif
+
+  printf("     n  kernel         time per call   time per box\n");
+  run(500, kernels, kernelCount);
+  run(5000, kernels, kernelCount);
+  return 0;
+}
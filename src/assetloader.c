@@ -0,0 +1,205 @@
+#include "assetloader.h"
+#include "profile.h"
+#include "trace.h"
+#include <stdlib.h>
+
+static void *asset_worker(void *arg) {
+  AssetLoader *loader = arg;
+  if (trace_enabled()) {
+    trace_thread_name("assets");
+  }
+  pthread_mutex_lock(&loader->lock);
+  for (;;) {
+    while (!loader->stopping && loader->nextDecode == loader->count) {
+      pthread_cond_wait(&loader->wake, &loader->lock);
+    }
+    if (loader->stopping) {
+      break;
+    }
+    int r = loader->nextDecode++;
+    AssetRequest *request = &loader->requests[r];
+    pthread_mutex_unlock(&loader->lock);
+    bool decoded;
+    {
+      TRACE_SCOPE("asset decode");
+      decoded = request->decode(request->user);
+    }
+    pthread_mutex_lock(&loader->lock);
+    request->decoded = decoded;
+    loader->ready[loader->readyTail++] = r;
+    // asset_loader_finish may be waiting on it
+    pthread_cond_broadcast(&loader->wake);
+  }
+  pthread_mutex_unlock(&loader->lock);
+  return NULL;
+}
+
+void asset_loader_start(AssetLoader *loader) {
+  loader->count = 0;
+  loader->nextDecode = 0;
+  loader->readyHead = 0;
+  loader->readyTail = 0;
+  loader->pending = 0;
+  loader->stopping = false;
+  pthread_mutex_init(&loader->lock, NULL);
+  pthread_cond_init(&loader->wake, NULL);
+  for (int t = 0; t < ASSET_LOADER_THREADS; t++) {
+    pthread_create(&loader->threads[t], NULL, asset_worker, loader);
+  }
+}
+
+static void upload_request(AssetLoader *loader, AssetRequest *request,
+                           bool decoded) {
+  TRACE_SCOPE("asset upload");
+  bool loaded = request->upload(request->user, decoded) && decoded;
+  request->state = loaded ? ASSET_LOADED : ASSET_FAILED;
+  loader->pending--;
+  if (!loaded) {
+    TraceLog(LOG_WARNING, "ASSETS: Could not load %s", request->name);
+  }
+}
+
+void asset_loader_stop(AssetLoader *loader) {
+  pthread_mutex_lock(&loader->lock);
+  loader->stopping = true;
+  pthread_cond_broadcast(&loader->wake);
+  pthread_mutex_unlock(&loader->lock);
+  for (int t = 0; t < ASSET_LOADER_THREADS; t++) {
+    pthread_join(loader->threads[t], NULL);
+  }
+  // what the workers finished is uploaded, what they never took is dropped
+  asset_loader_upload(loader, UINT64_MAX);
+  for (int r = loader->nextDecode; r < loader->count; r++) {
+    upload_request(loader, &loader->requests[r], false);
+  }
+  pthread_cond_destroy(&loader->wake);
+  pthread_mutex_destroy(&loader->lock);
+}
+
+AssetHandle asset_loader_add(AssetLoader *loader, const char *name,
+                             AssetDecodeFn decode, AssetUploadFn upload,
+                             void *user) {
+  pthread_mutex_lock(&loader->lock);
+  if (loader->count == ASSET_LOADER_MAX_REQUESTS) {
+    pthread_mutex_unlock(&loader->lock);
+    TraceLog(LOG_WARNING, "ASSETS: No room to queue %s", name);
+    return -1;
+  }
+  AssetHandle handle = loader->count++;
+  loader->requests[handle] = (AssetRequest){.name = name,
+                                            .decode = decode,
+                                            .upload = upload,
+                                            .user = user,
+                                            .state = ASSET_PENDING};
+  loader->pending++;
+  pthread_cond_broadcast(&loader->wake);
+  pthread_mutex_unlock(&loader->lock);
+  return handle;
+}
+
+int asset_loader_upload(AssetLoader *loader, uint64_t budgetNs) {
+  uint64_t start = profile_now_ns();
+  pthread_mutex_lock(&loader->lock);
+  while (loader->readyHead < loader->readyTail) {
+    int r = loader->ready[loader->readyHead++];
+    AssetRequest *request = &loader->requests[r];
+    bool decoded = request->decoded;
+    pthread_mutex_unlock(&loader->lock);
+    upload_request(loader, request, decoded);
+    pthread_mutex_lock(&loader->lock);
+    if (profile_now_ns() - start >= budgetNs) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&loader->lock);
+  return loader->pending;
+}
+
+void asset_loader_finish(AssetLoader *loader) {
+  while (asset_loader_upload(loader, UINT64_MAX) > 0) {
+    pthread_mutex_lock(&loader->lock);
+    while (loader->readyHead == loader->readyTail) {
+      pthread_cond_wait(&loader->wake, &loader->lock);
+    }
+    pthread_mutex_unlock(&loader->lock);
+  }
+}
+
+AssetState asset_loader_state(const AssetLoader *loader, AssetHandle handle) {
+  if (handle < 0 || handle >= loader->count) {
+    return ASSET_FAILED;
+  }
+  return loader->requests[handle].state;
+}
+
+typedef struct {
+  const char *path;
+  Image image;
+  Texture2D *texture;
+} TextureRequest;
+
+static bool texture_decode(void *user) {
+  TextureRequest *request = user;
+  request->image = LoadImage(request->path);
+  return IsImageValid(request->image);
+}
+
+static bool texture_upload(void *user, bool decoded) {
+  TextureRequest *request = user;
+  bool loaded = false;
+  if (decoded) {
+    *request->texture = LoadTextureFromImage(request->image);
+    loaded = IsTextureValid(*request->texture);
+    UnloadImage(request->image);
+  }
+  free(request);
+  return loaded;
+}
+
+AssetHandle asset_loader_texture(AssetLoader *loader, const char *path,
+                                 Texture2D *texture) {
+  TextureRequest *request = malloc(sizeof(TextureRequest));
+  *request = (TextureRequest){.path = path, .texture = texture};
+  AssetHandle handle = asset_loader_add(loader, path, texture_decode,
+                                        texture_upload, request);
+  if (handle < 0) {
+    free(request);
+  }
+  return handle;
+}
+
+typedef struct {
+  const char *path;
+  Wave wave;
+  Sound *sound;
+} SoundRequest;
+
+static bool sound_decode(void *user) {
+  SoundRequest *request = user;
+  request->wave = LoadWave(request->path);
+  return IsWaveValid(request->wave);
+}
+
+static bool sound_upload(void *user, bool decoded) {
+  SoundRequest *request = user;
+  bool loaded = false;
+  if (decoded) {
+    *request->sound = LoadSoundFromWave(request->wave);
+    loaded = IsSoundValid(*request->sound);
+    UnloadWave(request->wave);
+  }
+  free(request);
+  return loaded;
+}
+
+AssetHandle asset_loader_sound(AssetLoader *loader, const char *path,
+                               Sound *sound) {
+  SoundRequest *request = malloc(sizeof(SoundRequest));
+  *request = (SoundRequest){.path = path, .sound = sound};
+  AssetHandle handle =
+      asset_loader_add(loader, path, sound_decode, sound_upload, request);
+  if (handle < 0) {
+    free(request);
+  }
+  return handle;
+}
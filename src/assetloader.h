@@ -0,0 +1,83 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+// Loads assets behind the main thread. A request is split in two: a decode
+// step run by a worker thread (file I/O, LoadImage, LoadWave, anything that
+// only touches memory) and an upload step for the part that must run on the
+// main thread (LoadTextureFromImage, LoadSoundFromWave, anything that talks
+// to the GPU or the audio device). Decoded requests wait, in the order they
+// finished, for asset_loader_upload, which the main thread calls once a
+// frame with a time budget. Each request gets a handle whose state tells the
+// game whether it may use the asset yet, so it can hold a loading screen for
+// what it needs and stream the rest in behind gameplay.
+
+#include "raylib.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ASSET_LOADER_THREADS 2
+#define ASSET_LOADER_MAX_REQUESTS 64
+
+typedef enum { ASSET_PENDING = 0, ASSET_LOADED, ASSET_FAILED } AssetState;
+
+typedef int AssetHandle;
+
+// Worker side: must not call into the GPU or the audio device
+typedef bool (*AssetDecodeFn)(void *user);
+// Main thread side. Runs exactly once per request, with decoded false if
+// decode failed or never ran, so it can free what the request holds.
+typedef bool (*AssetUploadFn)(void *user, bool decoded);
+
+typedef struct {
+  const char *name;
+  AssetDecodeFn decode;
+  AssetUploadFn upload;
+  void *user;
+  // set by the worker under the lock
+  bool decoded;
+  // main thread only
+  AssetState state;
+} AssetRequest;
+
+typedef struct {
+  AssetRequest requests[ASSET_LOADER_MAX_REQUESTS];
+  int count;
+  // next request for a worker to take
+  int nextDecode;
+  // decoded requests waiting for upload, in the order they finished
+  int ready[ASSET_LOADER_MAX_REQUESTS];
+  int readyHead;
+  int readyTail;
+  int pending;
+  bool stopping;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_t threads[ASSET_LOADER_THREADS];
+} AssetLoader;
+
+void asset_loader_start(AssetLoader *loader);
+// Wait for the workers, then run the upload step of everything not yet
+// uploaded, so every request's resources end up owned or freed
+void asset_loader_stop(AssetLoader *loader);
+
+// Queue a request. Returns -1 when the loader is full.
+AssetHandle asset_loader_add(AssetLoader *loader, const char *name,
+                             AssetDecodeFn decode, AssetUploadFn upload,
+                             void *user);
+// LoadImage on a worker, LoadTextureFromImage into texture on upload
+AssetHandle asset_loader_texture(AssetLoader *loader, const char *path,
+                                 Texture2D *texture);
+// LoadWave on a worker, LoadSoundFromWave into sound on upload
+AssetHandle asset_loader_sound(AssetLoader *loader, const char *path,
+                               Sound *sound);
+
+// Upload decoded requests until budgetNs has passed. One upload always runs
+// if any is ready, so loading moves on however small the budget. Returns the
+// number of requests not yet loaded or failed.
+int asset_loader_upload(AssetLoader *loader, uint64_t budgetNs);
+// Upload everything, waiting for the workers as needed
+void asset_loader_finish(AssetLoader *loader);
+AssetState asset_loader_state(const AssetLoader *loader, AssetHandle handle);
+
+#endif
@@ -0,0 +1,222 @@
+#include "assetpack.h"
+#include "log.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static unsigned char *put(unsigned char *out, uint32_t value, int bytes) {
+  for (int b = 0; b < bytes; b++) {
+    out[b] = (value >> (b * 8)) & 0xFF;
+  }
+  return out + bytes;
+}
+
+static uint32_t get(const unsigned char **in, int bytes) {
+  uint32_t value = 0;
+  for (int b = 0; b < bytes; b++) {
+    value |= (uint32_t)(*in)[b] << (b * 8);
+  }
+  *in += bytes;
+  return value;
+}
+
+// Bytes an entry must hold for its kind and shape, or 0 for any size
+static size_t expected_size(const AssetEntry *entry) {
+  switch (entry->kind) {
+  case ASSET_IMAGE_RGBA8:
+    return (size_t)entry->width * entry->height * 4;
+  case ASSET_SOUND_PCM:
+    return (size_t)entry->frameCount * entry->channels *
+           (entry->sampleSize / 8);
+  default:
+    return 0;
+  }
+}
+
+static bool read_index(AssetPack *pack) {
+  if (pack->size < ASSET_PACK_HEADER_SIZE ||
+      memcmp(pack->data, "SSAP", 4) != 0) {
+    return false;
+  }
+  const unsigned char *p = pack->data + 4;
+  uint32_t version = get(&p, 2);
+  uint32_t count = get(&p, 2);
+  uint32_t size = get(&p, 4);
+  if (version != ASSET_PACK_VERSION || count > ASSET_PACK_MAX_ENTRIES ||
+      size != pack->size ||
+      ASSET_PACK_HEADER_SIZE + count * ASSET_PACK_ENTRY_SIZE > size) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    AssetEntry *entry = &pack->entries[i];
+    memcpy(entry->name, p, ASSET_NAME_SIZE);
+    p += ASSET_NAME_SIZE;
+    entry->kind = (AssetKind)get(&p, 4);
+    entry->offset = get(&p, 4);
+    entry->size = get(&p, 4);
+    uint32_t a = get(&p, 4);
+    uint32_t b = get(&p, 4);
+    uint32_t c = get(&p, 4);
+    if (entry->kind == ASSET_IMAGE_RGBA8) {
+      entry->width = (int)a;
+      entry->height = (int)b;
+    } else if (entry->kind == ASSET_SOUND_PCM) {
+      entry->frameCount = a;
+      entry->sampleRate = b;
+      entry->sampleSize = c & 0xFFFF;
+      entry->channels = c >> 16;
+    }
+    size_t expected = expected_size(entry);
+    if (entry->name[ASSET_NAME_SIZE - 1] != '\0' ||
+        entry->kind >= ASSET_KIND_COUNT || entry->offset > size ||
+        entry->size > size - entry->offset ||
+        (expected != 0 && entry->size != expected)) {
+      return false;
+    }
+  }
+  pack->count = (int)count;
+  return true;
+}
+
+bool asset_pack_open(AssetPack *pack, const char *path) {
+  memset(pack, 0, sizeof(AssetPack));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    game_log(GAME_LOG_WARNING, "ASSETS: Could not open %s\n", path);
+    return false;
+  }
+  struct stat info;
+  void *mapping = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    mapping = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  // the mapping keeps the file alive on its own
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    game_log(GAME_LOG_WARNING, "ASSETS: Could not map %s\n", path);
+    return false;
+  }
+  pack->data = mapping;
+  pack->size = info.st_size;
+  if (!read_index(pack)) {
+    game_log(GAME_LOG_WARNING,
+             "ASSETS: %s is not an asset pack for this build\n", path);
+    asset_pack_close(pack);
+    return false;
+  }
+  game_log(GAME_LOG_INFO, "ASSETS: Mapped %d assets, %zu bytes, from %s\n",
+           pack->count, pack->size, path);
+  return true;
+}
+
+void asset_pack_close(AssetPack *pack) {
+  if (pack->data != NULL) {
+    munmap((void *)pack->data, pack->size);
+  }
+  memset(pack, 0, sizeof(AssetPack));
+}
+
+const AssetEntry *asset_pack_find(const AssetPack *pack, const char *name,
+                                  AssetKind kind) {
+  for (int i = 0; i < pack->count; i++) {
+    if (pack->entries[i].kind == kind &&
+        strcmp(pack->entries[i].name, name) == 0) {
+      return &pack->entries[i];
+    }
+  }
+  return NULL;
+}
+
+const void *asset_pack_data(const AssetPack *pack, const AssetEntry *entry) {
+  return pack->data + entry->offset;
+}
+
+void asset_pack_prefetch(const AssetPack *pack, const AssetEntry *entry) {
+  long page = sysconf(_SC_PAGESIZE);
+  uintptr_t start = (uintptr_t)(pack->data + entry->offset) & ~(page - 1);
+  uintptr_t end = (uintptr_t)(pack->data + entry->offset + entry->size);
+  madvise((void *)start, end - start, MADV_WILLNEED);
+  volatile unsigned char sink = 0;
+  for (uintptr_t p = start; p < end; p += page) {
+    sink ^= *(const unsigned char *)p;
+  }
+  (void)sink;
+}
+
+bool asset_pack_add(AssetPackBuilder *builder, const AssetEntry *entry,
+                    const void *data) {
+  size_t expected = expected_size(entry);
+  if (builder->count == ASSET_PACK_MAX_ENTRIES ||
+      strlen(entry->name) >= ASSET_NAME_SIZE ||
+      (expected != 0 && entry->size != expected)) {
+    return false;
+  }
+  builder->entries[builder->count] = *entry;
+  builder->data[builder->count] = data;
+  builder->count++;
+  return true;
+}
+
+static uint32_t align(uint32_t offset) {
+  return (offset + ASSET_PACK_ALIGN - 1) & ~(uint32_t)(ASSET_PACK_ALIGN - 1);
+}
+
+bool asset_pack_write(const AssetPackBuilder *builder, const char *path) {
+  unsigned char header[ASSET_PACK_HEADER_SIZE +
+                       ASSET_PACK_MAX_ENTRIES * ASSET_PACK_ENTRY_SIZE];
+  uint32_t offsets[ASSET_PACK_MAX_ENTRIES];
+  uint32_t end =
+      ASSET_PACK_HEADER_SIZE + builder->count * ASSET_PACK_ENTRY_SIZE;
+  for (int i = 0; i < builder->count; i++) {
+    offsets[i] = align(end);
+    end = offsets[i] + builder->entries[i].size;
+  }
+
+  memcpy(header, "SSAP", 4);
+  unsigned char *p = put(header + 4, ASSET_PACK_VERSION, 2);
+  p = put(p, builder->count, 2);
+  p = put(p, end, 4);
+  for (int i = 0; i < builder->count; i++) {
+    const AssetEntry *entry = &builder->entries[i];
+    memset(p, 0, ASSET_NAME_SIZE);
+    memcpy(p, entry->name, strlen(entry->name));
+    p = put(p + ASSET_NAME_SIZE, entry->kind, 4);
+    p = put(p, offsets[i], 4);
+    p = put(p, entry->size, 4);
+    if (entry->kind == ASSET_IMAGE_RGBA8) {
+      p = put(p, entry->width, 4);
+      p = put(p, entry->height, 4);
+      p = put(p, 0, 4);
+    } else if (entry->kind == ASSET_SOUND_PCM) {
+      p = put(p, entry->frameCount, 4);
+      p = put(p, entry->sampleRate, 4);
+      p = put(p, entry->sampleSize | entry->channels << 16, 4);
+    } else {
+      p = put(p, 0, 4);
+      p = put(p, 0, 4);
+      p = put(p, 0, 4);
+    }
+  }
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  size_t written = (size_t)(p - header);
+  bool ok = fwrite(header, 1, written, file) == written;
+  static const unsigned char zeros[ASSET_PACK_ALIGN];
+  for (int i = 0; i < builder->count && ok; i++) {
+    ok = fwrite(zeros, 1, offsets[i] - written, file) == offsets[i] - written;
+    ok = ok && fwrite(builder->data[i], 1, builder->entries[i].size, file) ==
+                   builder->entries[i].size;
+    written = offsets[i] + builder->entries[i].size;
+  }
+  ok = fclose(file) == 0 && ok;
+  if (!ok) {
+    remove(path);
+  }
+  return ok;
+}
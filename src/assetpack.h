@@ -0,0 +1,89 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+// Every image and sound the game needs, baked offline by the assetPack step
+// into one indexed file. The sprite sheets are already packed into the atlas
+// and stored as raw RGBA8, sound effects as decoded PCM and the music as QOA,
+// so startup maps the file once and uploads straight from the mapping with
+// no PNG inflate or MP3 decode.
+//
+// assets.pack layout, all integers little-endian:
+//   "SSAP"  u16 version  u16 entries  u32 file size
+//   per entry:
+//     char name[32], zero padded  u32 kind  u32 offset  u32 size
+//     u32 a, b, c: width, height, 0 for images
+//                  frames, sample rate, bits | channels << 16 for PCM
+//   entry data at the offsets given, each aligned to ASSET_PACK_ALIGN
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_HEADER_SIZE 12
+#define ASSET_PACK_ENTRY_SIZE 56
+#define ASSET_NAME_SIZE 32
+#define ASSET_PACK_ALIGN 64
+#define ASSET_PACK_MAX_ENTRIES 64
+
+typedef enum {
+  // raw bytes for the caller to interpret
+  ASSET_DATA = 0,
+  // width * height pixels of 8-bit RGBA
+  ASSET_IMAGE_RGBA8,
+  // interleaved frames of the given bits per sample and channels
+  ASSET_SOUND_PCM,
+  // a whole .qoa file, streamed as music
+  ASSET_MUSIC_QOA,
+  ASSET_KIND_COUNT
+} AssetKind;
+
+typedef struct {
+  char name[ASSET_NAME_SIZE];
+  AssetKind kind;
+  uint32_t offset;
+  uint32_t size;
+  // images
+  int width;
+  int height;
+  // PCM sounds
+  unsigned int frameCount;
+  unsigned int sampleRate;
+  unsigned int sampleSize;
+  unsigned int channels;
+} AssetEntry;
+
+typedef struct {
+  // the whole file, mapped read-only
+  const unsigned char *data;
+  size_t size;
+  AssetEntry entries[ASSET_PACK_MAX_ENTRIES];
+  int count;
+} AssetPack;
+
+// Map a pack and read its index. Returns false, with the pack left empty,
+// if the file is missing or is not a pack for this build.
+bool asset_pack_open(AssetPack *pack, const char *path);
+void asset_pack_close(AssetPack *pack);
+// Entry of the given name and kind, or NULL
+const AssetEntry *asset_pack_find(const AssetPack *pack, const char *name,
+                                  AssetKind kind);
+// Where an entry's data starts inside the mapping
+const void *asset_pack_data(const AssetPack *pack, const AssetEntry *entry);
+// Fault an entry's pages in, so a loader thread waits on the disk rather
+// than whoever uploads from the mapping
+void asset_pack_prefetch(const AssetPack *pack, const AssetEntry *entry);
+
+// Writing, for the assetPack step. Entries are laid out in the order they
+// are added; data is copied in by asset_pack_write.
+typedef struct {
+  AssetEntry entries[ASSET_PACK_MAX_ENTRIES];
+  const void *data[ASSET_PACK_MAX_ENTRIES];
+  int count;
+} AssetPackBuilder;
+
+bool asset_pack_add(AssetPackBuilder *builder, const AssetEntry *entry,
+                    const void *data);
+bool asset_pack_write(const AssetPackBuilder *builder, const char *path);
+
+#endif
@@ -0,0 +1,114 @@
+// Build step for the asset pack. Decodes every sprite sheet and sound listed
+// in assets.c and writes them, ready to upload, into one file the game maps
+// at startup (see assetpack.h):
+//
+//   - the sprite sheets packed into the atlas, as raw RGBA8
+//   - the music re-encoded as QOA, which raylib streams from memory
+//   - the sound effects decoded to 16-bit PCM
+//
+//   assetPack OUT ROOT
+//
+// ROOT is the directory the paths in assets.c are relative to, src/assets
+// in the source tree.
+#include "assetpack.h"
+#include "assets.h"
+#include "atlas.h"
+#include "raylib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void fail(const char *message, const char *detail) {
+  fprintf(stderr, "assetPack: %s%s%s\n", message, detail ? ": " : "",
+          detail ? detail : "");
+  exit(1);
+}
+
+static void add(AssetPackBuilder *builder, const AssetEntry *entry,
+                const void *data) {
+  if (!asset_pack_add(builder, entry, data)) {
+    fail("cannot add to the pack", entry->name);
+  }
+}
+
+// raylib only encodes QOA to a file, so go through one next to the output
+static unsigned char *encode_qoa(Wave *wave, const char *out, int *size) {
+  char path[1024];
+  snprintf(path, sizeof(path), "%s.qoa", out);
+  WaveFormat(wave, wave->sampleRate, 16, wave->channels);
+  if (!ExportWave(*wave, path)) {
+    fail("cannot encode", path);
+  }
+  unsigned char *data = LoadFileData(path, size);
+  remove(path);
+  return data;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s OUT ROOT\n", argv[0]);
+    return 1;
+  }
+  const char *root = argv[2];
+  SetTraceLogLevel(LOG_WARNING);
+  AssetPackBuilder builder = {.count = 0};
+
+  Atlas atlas;
+  Image packed;
+  if (!atlas_pack(&atlas, &packed, root, spriteImages, SPRITE_COUNT)) {
+    fail("cannot pack the sprite sheets", NULL);
+  }
+  add(&builder,
+      &(AssetEntry){.name = ATLAS_PACK_IMAGE,
+                    .kind = ASSET_IMAGE_RGBA8,
+                    .size = packed.width * packed.height * 4,
+                    .width = packed.width,
+                    .height = packed.height},
+      packed.data);
+  unsigned char sprites[ATLAS_SPRITES_SIZE(ATLAS_MAX_SPRITES)];
+  atlas_encode_sprites(&atlas, sprites);
+  add(&builder,
+      &(AssetEntry){.name = ATLAS_PACK_SPRITES,
+                    .kind = ASSET_DATA,
+                    .size = ATLAS_SPRITES_SIZE(atlas.count)},
+      sprites);
+
+  Wave waves[SOUND_COUNT];
+  unsigned char *music = NULL;
+  for (int s = 0; s < SOUND_COUNT; s++) {
+    char path[ASSET_PATH_MAX];
+    asset_source_path(path, sizeof(path), root, soundFiles[s]);
+    waves[s] = LoadWave(path);
+    if (!IsWaveValid(waves[s])) {
+      fail("cannot decode", path);
+    }
+    AssetEntry entry = {.kind = ASSET_SOUND_PCM};
+    strcpy(entry.name, soundNames[s]);
+    if (s == SOUND_MUSIC) {
+      int size;
+      music = encode_qoa(&waves[s], argv[1], &size);
+      entry.kind = ASSET_MUSIC_QOA;
+      entry.size = size;
+      add(&builder, &entry, music);
+      continue;
+    }
+    WaveFormat(&waves[s], waves[s].sampleRate, 16, waves[s].channels);
+    entry.frameCount = waves[s].frameCount;
+    entry.sampleRate = waves[s].sampleRate;
+    entry.sampleSize = waves[s].sampleSize;
+    entry.channels = waves[s].channels;
+    entry.size = entry.frameCount * entry.channels * 2;
+    add(&builder, &entry, waves[s].data);
+  }
+
+  bool ok = asset_pack_write(&builder, argv[1]);
+  UnloadImage(packed);
+  UnloadFileData(music);
+  for (int s = 0; s < SOUND_COUNT; s++) {
+    UnloadWave(waves[s]);
+  }
+  if (!ok) {
+    fail("cannot write", argv[1]);
+  }
+  return 0;
+}
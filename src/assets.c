@@ -0,0 +1,50 @@
+#include "assets.h"
+#include <stdio.h>
+
+const char *const spriteImages[SPRITE_COUNT] = {
+    [ARCHETYPE_CRATE] = "images/crate.png",
+    [ARCHETYPE_CAKE] = "images/cake.png",
+    [ARCHETYPE_COCONUT] = "images/coconut.png",
+    [ARCHETYPE_MANGO] = "images/mango.png",
+    [ARCHETYPE_SODA] = "images/soda.png",
+    [ARCHETYPE_TEA] = "images/tea.png",
+    [ARCHETYPE_STRAW] = "images/straw.png",
+    [ARCHETYPE_RINGS] = "images/rings.png",
+    [ARCHETYPE_ANCHOR] = "images/anchor.png",
+    [ARCHETYPE_JELLYFISH] = "images/jellyfish.png",
+    [ARCHETYPE_OILSPILL] = "images/oilspill.png",
+    [ARCHETYPE_ORCA] = "images/orca.png",
+    [ARCHETYPE_EEL] = "images/eel.png",
+    [ARCHETYPE_KRAKEN] = "images/kraken.png",
+    [ARCHETYPE_HARPOON] = "images/harpoon.png",
+    [ARCHETYPE_SHARK] = "images/shark.png",
+    [SPRITE_SAND] = "images/sand.png",
+    [SPRITE_TIKI] = "images/tiki.png",
+    [SPRITE_PALM] = "images/palmtree.png",
+    [SPRITE_ROCK] = "images/rock.png",
+    [SPRITE_HEART] = "images/heart1.png",
+    [SPRITE_HEART_HALF] = "images/heart2.png",
+    [SPRITE_HEART_EMPTY] = "images/heart3.png",
+};
+
+const char *const soundFiles[SOUND_COUNT] = {
+    [SOUND_MUSIC] = "sounds/background_music.mp3",
+    [SOUND_PROJECTILE] = "sounds/projectile.wav",
+    [SOUND_CRATE] = "sounds/breaking_crates.wav",
+    [SOUND_UMBRELLA] = "sounds/umbrella.wav",
+    [SOUND_YUMMY] = "sounds/yummy.wav",
+};
+
+const char *const soundNames[SOUND_COUNT] = {
+    [SOUND_MUSIC] = "background_music",
+    [SOUND_PROJECTILE] = "projectile",
+    [SOUND_CRATE] = "breaking_crates",
+    [SOUND_UMBRELLA] = "umbrella",
+    [SOUND_YUMMY] = "yummy",
+};
+
+const char *asset_source_path(char *buffer, size_t size, const char *root,
+                              const char *file) {
+  snprintf(buffer, size, "%s/%s", root, file);
+  return buffer;
+}
@@ -0,0 +1,52 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+// Every sprite sheet and sound the game uses. Shared by the game, which falls
+// back to loading these files one by one, and the assetPack step, which
+// bakes them all into the asset pack.
+
+#include "game.h"
+#include <stddef.h>
+
+// Where the game finds the source files when there is no asset pack; the
+// build points it at the source tree
+#ifndef ASSET_SOURCE_DIR
+#define ASSET_SOURCE_DIR "../src/assets"
+#endif
+#define ASSET_PATH_MAX 1024
+
+// Sprites other than the archetypes, numbered after them in the atlas
+typedef enum {
+  SPRITE_SAND = ARCHETYPE_COUNT,
+  SPRITE_TIKI,
+  SPRITE_PALM,
+  SPRITE_ROCK,
+  SPRITE_HEART,
+  SPRITE_HEART_HALF,
+  SPRITE_HEART_EMPTY,
+  SPRITE_COUNT
+} SpriteId;
+
+// Source image of each sprite, relative to the asset source directory
+extern const char *const spriteImages[SPRITE_COUNT];
+
+// The music is streamed, the rest are short effects
+typedef enum {
+  SOUND_MUSIC = 0,
+  SOUND_PROJECTILE,
+  SOUND_CRATE,
+  SOUND_UMBRELLA,
+  SOUND_YUMMY,
+  SOUND_COUNT
+} SoundId;
+
+// Source file of each sound, relative to the asset source directory, and
+// the name it has in the asset pack
+extern const char *const soundFiles[SOUND_COUNT];
+extern const char *const soundNames[SOUND_COUNT];
+
+// root/file in buffer, which it returns
+const char *asset_source_path(char *buffer, size_t size, const char *root,
+                              const char *file);
+
+#endif
@@ -0,0 +1,166 @@
+#include "atlas.h"
+#include "assets.h"
+#include "trace.h"
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+// private copy, raylib's own is not part of its public API
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "external/stb_rect_pack.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+#define ATLAS_MIN_SIZE 256
+#define ATLAS_MAX_SIZE 4096
+
+bool atlas_pack(Atlas *atlas, Image *packed, const char *root,
+                const char *const *files, int count) {
+  static stbrp_node nodes[ATLAS_MAX_SIZE];
+  Image images[ATLAS_MAX_SPRITES + 1];
+  stbrp_rect rects[ATLAS_MAX_SPRITES + 1];
+  if (count > ATLAS_MAX_SPRITES) {
+    // the ones cut off would have no rectangle to draw from
+    TraceLog(LOG_WARNING, "ATLAS: %d sprites, only %d fit", count,
+             ATLAS_MAX_SPRITES);
+    return false;
+  }
+  for (int i = 0; i < count; i++) {
+    char path[ASSET_PATH_MAX];
+    images[i] =
+        LoadImage(asset_source_path(path, sizeof(path), root, files[i]));
+    // a sprite that did not load would be packed as an empty rectangle
+    if (images[i].data == NULL) {
+      TraceLog(LOG_WARNING, "ATLAS: Cannot load %s", path);
+      for (int j = 0; j < i; j++) {
+        UnloadImage(images[j]);
+      }
+      return false;
+    }
+    ImageFormat(&images[i], PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+  }
+  // the last entry is the white block for shapes
+  images[count] = GenImageColor(3, 3, WHITE);
+  for (int i = 0; i <= count; i++) {
+    rects[i] = (stbrp_rect){.id = i,
+                            .w = images[i].width + 2 * ATLAS_PADDING,
+                            .h = images[i].height + 2 * ATLAS_PADDING};
+  }
+
+  // smallest power-of-two square that holds everything
+  int size = ATLAS_MIN_SIZE;
+  stbrp_context context;
+  for (;; size *= 2) {
+    if (size > ATLAS_MAX_SIZE) {
+      TraceLog(LOG_WARNING, "ATLAS: Sprites do not fit in %dx%d",
+               ATLAS_MAX_SIZE, ATLAS_MAX_SIZE);
+      for (int i = 0; i <= count; i++) {
+        UnloadImage(images[i]);
+      }
+      return false;
+    }
+    stbrp_init_target(&context, size, size, nodes, size);
+    if (stbrp_pack_rects(&context, rects, count + 1)) {
+      break;
+    }
+  }
+
+  *packed = GenImageColor(size, size, BLANK);
+  for (int i = 0; i <= count; i++) {
+    Rectangle source = {0, 0, images[i].width, images[i].height};
+    Rectangle dest = {rects[i].x + ATLAS_PADDING, rects[i].y + ATLAS_PADDING,
+                      images[i].width, images[i].height};
+    ImageDraw(packed, images[i], source, dest, WHITE);
+    if (i < count) {
+      atlas->sprites[rects[i].id] = dest;
+    } else {
+      // centre pixel, so filtering never samples past the block
+      atlas->white = (Rectangle){dest.x + 1, dest.y + 1, 1, 1};
+    }
+    UnloadImage(images[i]);
+  }
+  atlas->count = count;
+  TraceLog(LOG_INFO, "ATLAS: Packed %d sprites into %dx%d", count, size,
+           size);
+  return true;
+}
+
+static Rectangle get_rectangle(const unsigned char *in) {
+  return (Rectangle){in[0] | in[1] << 8, in[2] | in[3] << 8,
+                     in[4] | in[5] << 8, in[6] | in[7] << 8};
+}
+
+static unsigned char *put_rectangle(unsigned char *out, Rectangle r) {
+  int values[4] = {r.x, r.y, r.width, r.height};
+  for (int v = 0; v < 4; v++) {
+    *out++ = values[v] & 0xFF;
+    *out++ = (values[v] >> 8) & 0xFF;
+  }
+  return out;
+}
+
+void atlas_encode_sprites(const Atlas *atlas, unsigned char *out) {
+  out[0] = atlas->count & 0xFF;
+  out[1] = (atlas->count >> 8) & 0xFF;
+  out += 2;
+  for (int i = 0; i < atlas->count; i++) {
+    out = put_rectangle(out, atlas->sprites[i]);
+  }
+  put_rectangle(out, atlas->white);
+}
+
+bool atlas_read_pack(Atlas *atlas, Image *pixels, const AssetPack *pack) {
+  const AssetEntry *image =
+      asset_pack_find(pack, ATLAS_PACK_IMAGE, ASSET_IMAGE_RGBA8);
+  const AssetEntry *sprites =
+      asset_pack_find(pack, ATLAS_PACK_SPRITES, ASSET_DATA);
+  if (image == NULL || sprites == NULL || sprites->size < 2) {
+    TraceLog(LOG_WARNING, "ATLAS: No baked atlas in the asset pack");
+    return false;
+  }
+  const unsigned char *in = asset_pack_data(pack, sprites);
+  int count = in[0] | in[1] << 8;
+  if (count > ATLAS_MAX_SPRITES ||
+      sprites->size != (uint32_t)ATLAS_SPRITES_SIZE(count)) {
+    TraceLog(LOG_WARNING, "ATLAS: Baked atlas has a bad sprite table");
+    return false;
+  }
+  in += 2;
+  for (int i = 0; i < count; i++, in += 8) {
+    atlas->sprites[i] = get_rectangle(in);
+  }
+  atlas->white = get_rectangle(in);
+  atlas->count = count;
+
+  // rlgl only reads the pixels, so the image can point into the mapping
+  asset_pack_prefetch(pack, image);
+  *pixels = (Image){.data = (void *)asset_pack_data(pack, image),
+                    .width = image->width,
+                    .height = image->height,
+                    .mipmaps = 1,
+                    .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+  TraceLog(LOG_INFO, "ATLAS: Read %d baked sprites, %dx%d", count,
+           image->width, image->height);
+  return true;
+}
+
+void atlas_upload(Atlas *atlas, Image pixels) {
+  TRACE_SCOPE("LoadTextureFromImage");
+  atlas->texture = LoadTextureFromImage(pixels);
+}
+
+void atlas_free(Atlas *atlas) {
+  UnloadTexture(atlas->texture);
+  atlas->count = 0;
+}
+
+void atlas_queue(const Atlas *atlas, SpriteQueue *queue, SpriteLayer layer,
+                 int sprite, Rectangle source, Vector2 position) {
+  Rectangle dest = {position.x, position.y, source.width, source.height};
+  source.x += atlas->sprites[sprite].x;
+  source.y += atlas->sprites[sprite].y;
+  sprite_queue_push(queue, layer, atlas->texture, source, dest, WHITE);
+}
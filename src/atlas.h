@@ -0,0 +1,50 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+// All sprite sheets packed into one texture at startup. Drawing every sprite
+// from the same texture lets rlgl keep a whole frame in one batch instead of
+// flushing on each texture switch.
+
+#include "assetpack.h"
+#include "raylib.h"
+#include "spritequeue.h"
+#include <stdbool.h>
+
+#define ATLAS_MAX_SPRITES 64
+// Empty pixels kept around each sprite so neighbours never bleed in
+#define ATLAS_PADDING 1
+// Names of the baked atlas in an asset pack: the pixels, and the sprite
+// rectangles as u16 count then x, y, width, height per sprite and the white
+// pixel last
+#define ATLAS_PACK_IMAGE "atlas"
+#define ATLAS_PACK_SPRITES "atlas.sprites"
+#define ATLAS_SPRITES_SIZE(count) (2 + ((count) + 1) * 8)
+
+typedef struct {
+  Texture2D texture;
+  // where each sprite sheet ended up inside the texture
+  Rectangle sprites[ATLAS_MAX_SPRITES];
+  int count;
+  // a plain white pixel, handed to SetShapesTexture so rectangles batch too
+  Rectangle white;
+} Atlas;
+
+// Pack the sprite sheets, files relative to root, into one RGBA8 image and
+// fill in the rectangles, without touching the GPU. The caller unloads
+// packed.
+bool atlas_pack(Atlas *atlas, Image *packed, const char *root,
+                const char *const *files, int count);
+// Read the atlas baked into an asset pack without touching the GPU. pixels
+// points into the pack's mapping, already faulted in.
+bool atlas_read_pack(Atlas *atlas, Image *pixels, const AssetPack *pack);
+// Upload the pixels from atlas_pack or atlas_read_pack, main thread only
+void atlas_upload(Atlas *atlas, Image pixels);
+// Rectangles in the pack's form, ATLAS_SPRITES_SIZE(atlas->count) bytes
+void atlas_encode_sprites(const Atlas *atlas, unsigned char *out);
+void atlas_free(Atlas *atlas);
+// Push part of one sprite sheet, source relative to the sheet, on a sprite
+// queue to be drawn when it is flushed
+void atlas_queue(const Atlas *atlas, SpriteQueue *queue, SpriteLayer layer,
+                 int sprite, Rectangle source, Vector2 position);
+
+#endif
@@ -0,0 +1,187 @@
+// Multi-core batch runner for pattern and difficulty balancing. Plays N
+// independent seeded sessions across all cores and writes histograms of how
+// long the shark survived, the score it reached and what hurt it.
+//
+//   gameBatch [--sessions N] [--seed S] [--threads T] [--max-ticks T]
+//             [--input MODE] [--out FILE]
+//
+// Session i is seeded with S + i and is played by the same bot as in gameSim,
+// so any row of a batch can be reproduced on its own with gameSim.
+#include "bot.h"
+#include "game.h"
+#include "gamedata.h"
+#include "workpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SURVIVAL_BIN_SECONDS 10
+#define SCORE_BIN 100
+#define SCORE_BINS 64
+
+// Histograms filled by one worker. Workers never share one, so the only
+// synchronisation in a batch is inside the work pool.
+typedef struct {
+  GameSession *session;
+  InputSource source;
+  unsigned long *survival;
+  unsigned long score[SCORE_BINS];
+  unsigned long damage[ARCHETYPE_COUNT];
+  unsigned long ticks;
+  unsigned long deaths;
+} WorkerContext;
+
+typedef struct {
+  WorkerContext *workers;
+  unsigned int seed;
+  unsigned long maxTicks;
+  int survivalBins;
+  InputMode mode;
+  const InputScript *script;
+} Batch;
+
+static InputScript script;
+
+static void play_session(int index, int worker, void *user) {
+  Batch *batch = user;
+  WorkerContext *context = &batch->workers[worker];
+  GameSession *session = context->session;
+  unsigned int seed = batch->seed + index;
+  game_session_reset(session, seed);
+  input_source_init(&context->source, batch->mode, batch->script, seed);
+  while (!game_over(session) && session->tick < batch->maxTicks) {
+    simulation_tick(session, input_next(&context->source));
+  }
+
+  int bin = session->tick / (SURVIVAL_BIN_SECONDS * TICK_RATE);
+  context->survival[bin < batch->survivalBins ? bin
+                                              : batch->survivalBins - 1]++;
+  bin = session->score / SCORE_BIN;
+  context->score[bin < SCORE_BINS ? bin : SCORE_BINS - 1]++;
+  for (int a = 0; a < ARCHETYPE_COUNT; a++) {
+    context->damage[a] += session->damageBy[a];
+  }
+  context->ticks += session->tick;
+  context->deaths += game_over(session);
+}
+
+static void write_csv(FILE *out, const Batch *batch, int threads) {
+  fprintf(out, "histogram,bin,count\n");
+  for (int b = 0; b < batch->survivalBins; b++) {
+    unsigned long count = 0;
+    for (int w = 0; w < threads; w++) {
+      count += batch->workers[w].survival[b];
+    }
+    fprintf(out, "survival_seconds,%d,%lu\n", b * SURVIVAL_BIN_SECONDS, count);
+  }
+  for (int b = 0; b < SCORE_BINS; b++) {
+    unsigned long count = 0;
+    for (int w = 0; w < threads; w++) {
+      count += batch->workers[w].score[b];
+    }
+    fprintf(out, "score,%d,%lu\n", b * SCORE_BIN, count);
+  }
+  for (int a = 0; a < ARCHETYPE_COUNT; a++) {
+    unsigned long count = 0;
+    for (int w = 0; w < threads; w++) {
+      count += batch->workers[w].damage[a];
+    }
+    fprintf(out, "damage,%s,%lu\n", archetypeNames[a], count);
+  }
+}
+
+int main(int argc, char **argv) {
+  int sessions = 1000;
+  int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  const char *outPath = NULL;
+  Batch batch = {NULL, 1, 10UL * 60 * TICK_RATE, 0, INPUT_MODE_RANDOM,
+                 &script};
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+      sessions = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      batch.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) {
+      batch.maxTicks = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+      const char *value = argv[++i];
+      if (strcmp(value, "random") == 0) {
+        batch.mode = INPUT_MODE_RANDOM;
+      } else if (strcmp(value, "idle") == 0) {
+        batch.mode = INPUT_MODE_IDLE;
+      } else if (input_script_load(&script, value)) {
+        batch.mode = INPUT_MODE_SCRIPT;
+      } else {
+        fprintf(stderr, "gameBatch: cannot read input script %s\n", value);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      outPath = argv[++i];
+    } else {
+      fprintf(stderr,
+              "usage: %s [--sessions N] [--seed S] [--threads T] "
+              "[--max-ticks T] [--input random|idle|FILE] [--out FILE]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (threads < 1) {
+    threads = 1;
+  }
+
+  gameLogLevel = GAME_LOG_WARNING;
+  log_start();
+  if (!game_init()) {
+    fprintf(stderr, "gameBatch: cannot load the game data table\n");
+    log_stop();
+    return 1;
+  }
+  // the last survival bin also holds the sessions that hit --max-ticks
+  batch.survivalBins =
+      batch.maxTicks / (SURVIVAL_BIN_SECONDS * TICK_RATE) + 1;
+  batch.workers = calloc(threads, sizeof(WorkerContext));
+  for (int w = 0; w < threads; w++) {
+    batch.workers[w].session = game_session_create(batch.seed);
+    batch.workers[w].survival =
+        calloc(batch.survivalBins, sizeof(unsigned long));
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  work_pool_run(threads, sessions, play_session, &batch);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double seconds =
+      (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  FILE *out = stdout;
+  if (outPath != NULL && (out = fopen(outPath, "w")) == NULL) {
+    fprintf(stderr, "gameBatch: cannot write %s\n", outPath);
+    log_stop();
+    return 1;
+  }
+  write_csv(out, &batch, threads);
+  if (out != stdout) {
+    fclose(out);
+  }
+
+  unsigned long totalTicks = 0;
+  unsigned long deaths = 0;
+  for (int w = 0; w < threads; w++) {
+    totalTicks += batch.workers[w].ticks;
+    deaths += batch.workers[w].deaths;
+    game_session_free(batch.workers[w].session);
+    free(batch.workers[w].survival);
+  }
+  free(batch.workers);
+  fprintf(stderr,
+          "gameBatch: %d sessions (%lu died) on %d threads, %lu ticks in "
+          "%.3f s (%.0f ticks/s)\n",
+          sessions, deaths, threads, totalTicks, seconds,
+          seconds > 0 ? totalTicks / seconds : 0.0);
+  log_stop();
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include "bot.h"
+#include "game.h"
+#include <stdio.h>
+#include <string.h>
+
+bool input_script_load(InputScript *script, const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    return false;
+  }
+  char keys[8];
+  unsigned int ticks;
+  script->count = 0;
+  while (script->count < MAX_SCRIPT_STEPS &&
+         fscanf(file, "%u %7s", &ticks, keys) == 2) {
+    if (ticks == 0) {
+      continue;
+    }
+    unsigned int input = 0;
+    if (strchr(keys, 'L') != NULL) {
+      input |= INPUT_LEFT;
+    }
+    if (strchr(keys, 'R') != NULL) {
+      input |= INPUT_RIGHT;
+    }
+    script->steps[script->count++] = (ScriptStep){ticks, input};
+  }
+  fclose(file);
+  return script->count > 0;
+}
+
+void input_source_init(InputSource *source, InputMode mode,
+                       const InputScript *script, unsigned int seed) {
+  source->mode = mode;
+  source->script = script;
+  source->rng = seed;
+  source->input = 0;
+  source->ticksLeft = 0;
+  source->step = -1;
+}
+
+unsigned int input_next(InputSource *source) {
+  switch (source->mode) {
+  case INPUT_MODE_IDLE:
+    return 0;
+  case INPUT_MODE_SCRIPT:
+    while (source->ticksLeft == 0) {
+      source->step = (source->step + 1) % source->script->count;
+      source->ticksLeft = source->script->steps[source->step].ticks;
+      source->input = source->script->steps[source->step].input;
+    }
+    break;
+  case INPUT_MODE_RANDOM:
+    if (source->ticksLeft == 0) {
+      // hold left, right or nothing for a quarter to one second
+      source->rng = source->rng * 1103515245u + 12345u;
+      source->input = (source->rng >> 16) % 3;
+      source->ticksLeft = 15 + (source->rng >> 8) % 46;
+    }
+    break;
+  }
+  source->ticksLeft--;
+  return source->input;
+}
@@ -0,0 +1,45 @@
+#ifndef BOT_H
+#define BOT_H
+
+// Scripted and random players for the headless tools. Each one turns a tick
+// into an input word the same way test.c turns the keyboard into one.
+
+#include <stdbool.h>
+
+#define MAX_SCRIPT_STEPS 1024
+
+typedef enum {
+  INPUT_MODE_RANDOM,
+  INPUT_MODE_IDLE,
+  INPUT_MODE_SCRIPT
+} InputMode;
+
+typedef struct {
+  unsigned int ticks;
+  unsigned int input;
+} ScriptStep;
+
+// A script has one "<ticks> <keys>" pair per line, where keys is L, R, LR or
+// -, and is replayed in a loop. It is read once and then shared read-only.
+typedef struct {
+  ScriptStep steps[MAX_SCRIPT_STEPS];
+  int count;
+} InputScript;
+
+// Input source for one session. The random player has its own generator so
+// the game's random stream only depends on the session seed.
+typedef struct {
+  InputMode mode;
+  const InputScript *script;
+  unsigned int rng;
+  unsigned int input;
+  unsigned int ticksLeft;
+  int step;
+} InputSource;
+
+bool input_script_load(InputScript *script, const char *path);
+void input_source_init(InputSource *source, InputMode mode,
+                       const InputScript *script, unsigned int seed);
+unsigned int input_next(InputSource *source);
+
+#endif
@@ -0,0 +1,219 @@
+#include "game.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Bullets further than this outside the screen are culled
+#define BULLET_MARGIN 16
+
+// Unit vector of every whole degree, fixed point, filled by bullet_init.
+// Read-only afterwards like archetypes[], so sessions share it.
+static int directionX[360];
+static int directionY[360];
+
+void bullet_init(void) {
+  for (int d = 0; d < 360; d++) {
+    float radians = d * (float)M_PI / 180.0f;
+    directionX[d] = (int)lroundf(cosf(radians) * (1 << BULLET_SHIFT));
+    directionY[d] = (int)lroundf(sinf(radians) * (1 << BULLET_SHIFT));
+  }
+}
+
+// Velocity for a bullet heading degrees clockwise from +x (y points down)
+void bullet_direction(int degrees, int speed, int *vx, int *vy) {
+  int d = ((degrees % 360) + 360) % 360;
+  *vx = (directionX[d] * speed) >> BULLET_SHIFT;
+  *vy = (directionY[d] * speed) >> BULLET_SHIFT;
+}
+
+void bullet_pool_init(BulletPool *pool, int capacity) {
+  pool->x = malloc(capacity * sizeof(int));
+  pool->y = malloc(capacity * sizeof(int));
+  pool->vx = malloc(capacity * sizeof(int));
+  pool->vy = malloc(capacity * sizeof(int));
+  pool->owner = malloc(capacity * sizeof(unsigned char));
+  pool->candidates = malloc(capacity * sizeof(int));
+  pool->capacity = capacity;
+  bullet_pool_reset(pool);
+}
+
+void bullet_pool_reset(BulletPool *pool) { pool->count = 0; }
+
+void bullet_pool_free(BulletPool *pool) {
+  free(pool->x);
+  free(pool->y);
+  free(pool->vx);
+  free(pool->vy);
+  free(pool->owner);
+  free(pool->candidates);
+}
+
+// Add a bullet at pixel (x, y) moving (vx, vy) fixed point per tick. Returns
+// false when the pool is full.
+bool bullet_pool_spawn(BulletPool *pool, int x, int y, int vx, int vy,
+                       int owner) {
+  if (pool->count == pool->capacity) {
+    return false;
+  }
+  int i = pool->count++;
+  pool->x[i] = x << BULLET_SHIFT;
+  pool->y[i] = y << BULLET_SHIFT;
+  pool->vx[i] = vx;
+  pool->vy[i] = vy;
+  pool->owner[i] = owner;
+  return true;
+}
+
+// Copy the bullets whose keep flag is set down over the dropped ones. The
+// write index only advances on a kept bullet, so there is no branch to
+// mispredict however the dead ones are spread.
+static void bullet_pool_compact(BulletPool *pool, const unsigned char *keep) {
+  int n = 0;
+  for (int i = 0; i < pool->count; i++) {
+    pool->x[n] = pool->x[i];
+    pool->y[n] = pool->y[i];
+    pool->vx[n] = pool->vx[i];
+    pool->vy[n] = pool->vy[i];
+    pool->owner[n] = pool->owner[i];
+    n += keep[i];
+  }
+  pool->count = n;
+}
+
+// Move every bullet one tick, then drop the ones that have left the screen
+void bullet_pool_update(BulletPool *pool) {
+  int *x = pool->x;
+  int *y = pool->y;
+  const int *vx = pool->vx;
+  const int *vy = pool->vy;
+  int n = pool->count;
+  for (int i = 0; i < n; i++) {
+    x[i] += vx[i];
+    y[i] += vy[i];
+  }
+
+  const int minX = -(BULLET_MARGIN << BULLET_SHIFT);
+  const int minY = -(BULLET_MARGIN << BULLET_SHIFT);
+  const int maxX = (SCREEN_WIDTH + BULLET_MARGIN) << BULLET_SHIFT;
+  const int maxY = (SCREEN_HEIGHT + BULLET_MARGIN) << BULLET_SHIFT;
+  // the collision scratch is free outside bullet_pool_hit, so it holds the
+  // keep flags
+  unsigned char *keep = (unsigned char *)pool->candidates;
+  int culled = 0;
+  for (int i = 0; i < n; i++) {
+    keep[i] = (x[i] > minX) & (x[i] < maxX) & (y[i] > minY) & (y[i] < maxY);
+    culled += !keep[i];
+  }
+  if (culled > 0) {
+    bullet_pool_compact(pool, keep);
+  }
+}
+
+// Remove the bullets touching the box at (x, y) of size (w, h) and return how
+// many there were, counting each against its owner in damageBy.
+//
+// The coarse pass tests every bullet's centre against the box grown by the
+// bullet radius, a branch-free compare over the packed arrays. Only the few
+// bullets that pass get the exact circle against box test.
+int bullet_pool_hit(BulletPool *pool, int x, int y, int w, int h,
+                    unsigned int *damageBy) {
+  const int r = BULLET_RADIUS << BULLET_SHIFT;
+  const int minX = x << BULLET_SHIFT;
+  const int minY = y << BULLET_SHIFT;
+  const int maxX = (x + w) << BULLET_SHIFT;
+  const int maxY = (y + h) << BULLET_SHIFT;
+  const int *bx = pool->x;
+  const int *by = pool->y;
+  int *candidates = pool->candidates;
+  int n = 0;
+  for (int i = 0; i < pool->count; i++) {
+    int inside = (bx[i] > minX - r) & (bx[i] < maxX + r) &
+                 (by[i] > minY - r) & (by[i] < maxY + r);
+    candidates[n] = i;
+    n += inside;
+  }
+  if (n == 0) {
+    return 0;
+  }
+
+  // distance from the centre to the nearest point of the box, in whole
+  // pixels so the square cannot overflow
+  int hits = 0;
+  for (int c = 0; c < n; c++) {
+    int i = candidates[c];
+    int nearX = bx[i] < minX ? minX : (bx[i] > maxX ? maxX : bx[i]);
+    int nearY = by[i] < minY ? minY : (by[i] > maxY ? maxY : by[i]);
+    int dx = (bx[i] - nearX) >> BULLET_SHIFT;
+    int dy = (by[i] - nearY) >> BULLET_SHIFT;
+    if (dx * dx + dy * dy < BULLET_RADIUS * BULLET_RADIUS) {
+      candidates[hits++] = i;
+    }
+  }
+  if (hits == 0) {
+    return 0;
+  }
+
+  // candidates[0..hits) is in increasing order, so walking it alongside the
+  // pool compacts in one pass
+  int next = 0;
+  int kept = 0;
+  for (int i = 0; i < pool->count; i++) {
+    if (next < hits && candidates[next] == i) {
+      if (damageBy != NULL) {
+        damageBy[pool->owner[i]]++;
+      }
+      next++;
+      continue;
+    }
+    pool->x[kept] = pool->x[i];
+    pool->y[kept] = pool->y[i];
+    pool->vx[kept] = pool->vx[i];
+    pool->vy[kept] = pool->vy[i];
+    pool->owner[kept] = pool->owner[i];
+    kept++;
+  }
+  pool->count = kept;
+  return hits;
+}
+
+// Fire the volleys of every boss on screen whose emitter is due this tick.
+// The schedule runs off the boss' spawn tick, so it needs no state of its
+// own and a boss always opens fire period ticks after it appears.
+void boss_emit_bullets(GameSession *session) {
+  ParticleSystem *boss = &session->bosses;
+  BulletPool *pool = &session->bullets;
+  const Archetype *s = &archetypes[ARCHETYPE_SHARK];
+  int targetX = session->shark.x + s->frameWidth / 2;
+  int targetY = session->shark.y + s->frameHeight / 2;
+  int dropped = 0;
+  for (int k = 0; k < boss->count; k++) {
+    int i = boss->alive[k];
+    const Archetype *a = &archetypes[boss->archetype[i]];
+    const Emitter *e = &a->emitter;
+    unsigned long age = session->tick - boss->phase[i];
+    if (e->pattern == EMITTER_NONE || boss->y[i] < 0 || age == 0 ||
+        age % e->period != 0) {
+      continue;
+    }
+    int x = boss->x[i] + a->frameWidth / 2;
+    int y = boss->y[i] + a->frameHeight / 2;
+    int first = 0;
+    int step = 360 / e->count;
+    if (e->pattern == EMITTER_AIMED) {
+      float radians = atan2f(targetY - y, targetX - x);
+      int aim = (int)lroundf(radians * 180.0f / (float)M_PI);
+      step = e->count > 1 ? e->angle / (e->count - 1) : 0;
+      first = aim - step * (e->count - 1) / 2;
+    } else if (e->pattern == EMITTER_SPIRAL) {
+      first = (int)((age / e->period) * e->angle % 360);
+    }
+    for (int b = 0; b < e->count; b++) {
+      int vx, vy;
+      bullet_direction(first + b * step, e->speed, &vx, &vy);
+      dropped += !bullet_pool_spawn(pool, x, y, vx, vy, boss->archetype[i]);
+    }
+  }
+  if (dropped > 0) {
+    game_log(GAME_LOG_WARNING, "BULLET: Pool full, dropped %d bullets\n",
+             dropped);
+  }
+}
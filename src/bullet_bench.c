@@ -0,0 +1,97 @@
+// Benchmark for the boss bullet pool in bullet.c. Each level keeps N bullets
+// alive for a fixed number of ticks and times the per-tick work the
+// simulation does on them: move, cull and the shark collision test. The
+// budget column is the share of a 60 fps frame that work takes.
+#include "game.h"
+#include "profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_TICKS 2000
+#define FRAME_NS (1e9 / 60)
+
+static const int benchLevels[] = {1000, 5000, 10000};
+
+// Top up the pool with bullets anywhere on screen, heading anywhere
+static void bench_fill(BulletPool *pool, int level) {
+  while (pool->count < level) {
+    int vx, vy;
+    bullet_direction(rand() % 360, (1 + rand() % 3) << BULLET_SHIFT, &vx,
+                     &vy);
+    bullet_pool_spawn(pool, rand() % SCREEN_WIDTH, rand() % SCREEN_HEIGHT, vx,
+                      vy, ARCHETYPE_KRAKEN);
+  }
+}
+
+// The same circle against box test as bullet_pool_hit, one bullet at a time
+static int bench_expected_hits(const BulletPool *pool, int x, int y, int w,
+                               int h) {
+  int hits = 0;
+  for (int i = 0; i < pool->count; i++) {
+    int bx = pool->x[i] >> BULLET_SHIFT;
+    int by = pool->y[i] >> BULLET_SHIFT;
+    int nearX = bx < x ? x : (bx > x + w ? x + w : bx);
+    int nearY = by < y ? y : (by > y + h ? y + h : by);
+    int dx = bx - nearX;
+    int dy = by - nearY;
+    hits += dx * dx + dy * dy < BULLET_RADIUS * BULLET_RADIUS;
+  }
+  return hits;
+}
+
+static int compare_ns(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void bench_level(int level) {
+  static uint64_t times[BENCH_TICKS];
+  BulletPool pool;
+  bullet_pool_init(&pool, level);
+  const Archetype *s = &archetypes[ARCHETYPE_SHARK];
+  int sharkX = SCREEN_WIDTH / 2 - s->frameWidth / 2;
+  int sharkY = SCREEN_HEIGHT - s->frameHeight - 20;
+  unsigned int damageBy[ARCHETYPE_COUNT] = {0};
+  long expected = 0, hits = 0;
+  srand(level);
+
+  for (int t = 0; t < BENCH_TICKS; t++) {
+    bench_fill(&pool, level);
+    uint64_t start = profile_now_ns();
+    bullet_pool_update(&pool);
+    uint64_t moved = profile_now_ns();
+    // the check is not part of what is timed
+    expected += bench_expected_hits(&pool, sharkX, sharkY, s->frameWidth,
+                                    s->frameHeight);
+    uint64_t checked = profile_now_ns();
+    hits += bullet_pool_hit(&pool, sharkX, sharkY, s->frameWidth,
+                            s->frameHeight, damageBy);
+    times[t] = (moved - start) + (profile_now_ns() - checked);
+  }
+
+  uint64_t total = 0;
+  for (int t = 0; t < BENCH_TICKS; t++) {
+    total += times[t];
+  }
+  qsort(times, BENCH_TICKS, sizeof(uint64_t), compare_ns);
+  double mean = (double)total / BENCH_TICKS;
+  printf("%7d %10.1f %10.1f %10.1f %9.2f%%  %s\n", level, mean / 1000.0,
+         times[BENCH_TICKS * 95 / 100] / 1000.0,
+         times[BENCH_TICKS - 1] / 1000.0, 100.0 * mean / FRAME_NS,
+         hits == expected ? "ok" : "MISMATCH");
+  bullet_pool_free(&pool);
+}
+
+int main() {
+  if (!game_init()) {
+    fprintf(stderr, "bulletBench: cannot load the game data table\n");
+    return 1;
+  }
+  printf("bullets    mean us     p95 us     max us    budget\n");
+  for (unsigned int l = 0; l < sizeof(benchLevels) / sizeof(benchLevels[0]);
+       l++) {
+    bench_level(benchLevels[l]);
+  }
+  return 0;
+}
@@ -0,0 +1,205 @@
+#include "aabb.h"
+#include "game.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int grid_clamp(int v, int max) {
+  return v < 0 ? 0 : (v >= max ? max - 1 : v);
+}
+
+static int grid_cell(int x, int y) {
+  return grid_clamp(y / GRID_CELL_SIZE, GRID_ROWS) * GRID_COLS +
+         grid_clamp(x / GRID_CELL_SIZE, GRID_COLS);
+}
+
+void collision_grid_init(CollisionGrid *grid, int capacity) {
+  grid->handles = malloc(capacity * sizeof(int));
+  grid->minX = malloc(capacity * sizeof(int));
+  grid->minY = malloc(capacity * sizeof(int));
+  grid->maxX = malloc(capacity * sizeof(int));
+  grid->maxY = malloc(capacity * sizeof(int));
+  grid->hitMask = malloc(AABB_MASK_WORDS(capacity) * sizeof(uint32_t));
+  grid->results = malloc(capacity * sizeof(int));
+  grid->capacity = capacity;
+  grid->maxWidth = 0;
+  grid->maxHeight = 0;
+  memset(grid->cellStart, 0, sizeof(grid->cellStart));
+}
+
+void collision_grid_free(CollisionGrid *grid) {
+  free(grid->handles);
+  free(grid->minX);
+  free(grid->minY);
+  free(grid->maxX);
+  free(grid->maxY);
+  free(grid->hitMask);
+  free(grid->results);
+}
+
+// Rebuild the grid from the live particles with a counting sort, so it costs
+// two passes over the alive lists and no allocation.
+void collision_grid_build(CollisionGrid *grid, ParticleSystem *enemy,
+                          ParticleSystem *powerup) {
+  grid->layers[GRID_ENEMY] = enemy;
+  grid->layers[GRID_POWERUP] = powerup;
+  grid->maxWidth = 0;
+  grid->maxHeight = 0;
+  memset(grid->cellStart, 0, sizeof(grid->cellStart));
+
+  for (int l = 0; l < GRID_LAYERS; l++) {
+    ParticleSystem *system = grid->layers[l];
+    for (int k = 0; k < system->count; k++) {
+      int i = system->alive[k];
+      const Archetype *a = &archetypes[system->archetype[i]];
+      grid->cellStart[grid_cell(system->x[i], system->y[i]) + 1]++;
+      if (a->frameWidth > grid->maxWidth) {
+        grid->maxWidth = a->frameWidth;
+      }
+      if (a->frameHeight > grid->maxHeight) {
+        grid->maxHeight = a->frameHeight;
+      }
+    }
+  }
+  for (int c = 0; c < GRID_CELLS; c++) {
+    grid->cellStart[c + 1] += grid->cellStart[c];
+  }
+
+  int cursor[GRID_CELLS];
+  memcpy(cursor, grid->cellStart, sizeof(cursor));
+  for (int l = 0; l < GRID_LAYERS; l++) {
+    ParticleSystem *system = grid->layers[l];
+    for (int k = 0; k < system->count; k++) {
+      int i = system->alive[k];
+      const Archetype *a = &archetypes[system->archetype[i]];
+      int e = cursor[grid_cell(system->x[i], system->y[i])]++;
+      grid->handles[e] = GRID_HANDLE(l, i);
+      grid->minX[e] = system->x[i];
+      grid->minY[e] = system->y[i];
+      grid->maxX[e] = system->x[i] + a->frameWidth;
+      grid->maxY[e] = system->y[i] + a->frameHeight;
+    }
+  }
+}
+
+// Collect the handles of live particles on the layers in layerMask whose
+// bounds overlap the box at (x, y) of size (w, h). Returns how many were
+// written to out.
+int collision_grid_query(CollisionGrid *grid, int x, int y, int w, int h,
+                         int layerMask, int *out, int maxOut) {
+  int c0 = grid_clamp((x - grid->maxWidth) / GRID_CELL_SIZE, GRID_COLS);
+  int c1 = grid_clamp((x + w) / GRID_CELL_SIZE, GRID_COLS);
+  int r0 = grid_clamp((y - grid->maxHeight) / GRID_CELL_SIZE, GRID_ROWS);
+  int r1 = grid_clamp((y + h) / GRID_CELL_SIZE, GRID_ROWS);
+  uint32_t *hits = grid->hitMask;
+  int n = 0;
+  for (int r = r0; r <= r1; r++) {
+    int begin = grid->cellStart[r * GRID_COLS + c0];
+    int end = grid->cellStart[r * GRID_COLS + c1 + 1];
+    if (aabb_overlap(x, y, x + w, y + h, &grid->minX[begin],
+                     &grid->minY[begin], &grid->maxX[begin],
+                     &grid->maxY[begin], end - begin, hits) == 0) {
+      continue;
+    }
+    for (int word = 0; word < AABB_MASK_WORDS(end - begin); word++) {
+      for (uint32_t bits = hits[word]; bits != 0; bits &= bits - 1) {
+        int handle = grid->handles[begin + word * 32 + __builtin_ctz(bits)];
+        int layer = GRID_HANDLE_LAYER(handle);
+        if ((layerMask & (1 << layer)) &&
+            grid->layers[layer]->isAlive[GRID_HANDLE_SLOT(handle)] &&
+            n < maxOut) {
+          out[n++] = handle;
+        }
+      }
+    }
+  }
+  return n;
+}
+
+void player_particle_collision(GameSession *session) {
+  // find the particles overlapping the charecter
+  // if they are, delete particle and take away one life
+  // if not, do nothing
+  ParticleSystem *enemy = &session->enemies;
+  ParticleSystem *powerup = &session->powerups;
+  Player *shark = &session->shark;
+  const Archetype *s = &archetypes[ARCHETYPE_SHARK];
+  CollisionGrid *grid = &session->grid;
+  int *hits = grid->results;
+  int n = collision_grid_query(grid, shark->x, shark->y, s->frameWidth,
+                               s->frameHeight,
+                               (1 << GRID_ENEMY) | (1 << GRID_POWERUP), hits,
+                               grid->capacity);
+  for (int h = 0; h < n; h++) {
+    int j = GRID_HANDLE_SLOT(hits[h]);
+    if (GRID_HANDLE_LAYER(hits[h]) == GRID_ENEMY) {
+      enemy->isAlive[j] = false;
+      shark->health -= 1;
+      session->damageBy[enemy->archetype[j]]++;
+      session->events[GAME_EVENT_HURT]++;
+    } else {
+      // player and powerup collision
+      powerup->isAlive[j] = false;
+      session->events[GAME_EVENT_PICKUP]++;
+      // add player powerup ability
+    }
+  }
+  particle_system_sweep(enemy);
+  particle_system_sweep(powerup);
+}
+
+void player_projectile_collision(GameSession *session) {
+  ParticleSystem *projectile = &session->projectiles;
+  ParticleSystem *enemy = &session->enemies;
+  ParticleSystem *powerup = &session->powerups;
+  CollisionGrid *grid = &session->grid;
+  int *hits = grid->results;
+  for (int i = 0; i < projectile->count; i++) {
+    int harpoon = projectile->alive[i];
+    const Archetype *a = &archetypes[projectile->archetype[harpoon]];
+    int n = collision_grid_query(grid, projectile->x[harpoon],
+                                 projectile->y[harpoon], a->frameWidth * 2,
+                                 a->frameHeight,
+                                 (1 << GRID_ENEMY) | (1 << GRID_POWERUP),
+                                 hits, grid->capacity);
+    for (int h = 0; h < n; h++) {
+      int j = GRID_HANDLE_SLOT(hits[h]);
+      if (GRID_HANDLE_LAYER(hits[h]) == GRID_ENEMY) {
+        projectile->isAlive[harpoon] = false;
+        enemy->health[j] -= 1;
+      } else if ((powerup->type[j] & BOX) == BOX) {
+        // Check for box collision
+        powerup->health[j]--;
+        session->events[GAME_EVENT_CRATE_HIT]++;
+      }
+    }
+  }
+  particle_system_sweep(projectile);
+}
+
+// Boss bullets against the shark. The bullets that land in one tick cost a
+// single life, put down to the boss that landed most of them, and bullets
+// then pass through the shark for BULLET_GRACE_TICKS.
+void player_bullet_collision(GameSession *session) {
+  if (session->bulletGraceTicks > 0) {
+    session->bulletGraceTicks--;
+    return;
+  }
+  Player *shark = &session->shark;
+  const Archetype *s = &archetypes[ARCHETYPE_SHARK];
+  unsigned int landed[ARCHETYPE_COUNT] = {0};
+  int hits = bullet_pool_hit(&session->bullets, shark->x, shark->y,
+                             s->frameWidth, s->frameHeight, landed);
+  if (hits == 0) {
+    return;
+  }
+  int owner = 0;
+  for (int a = 1; a < ARCHETYPE_COUNT; a++) {
+    if (landed[a] > landed[owner]) {
+      owner = a;
+    }
+  }
+  shark->health -= 1;
+  session->damageBy[owner]++;
+  session->events[GAME_EVENT_HURT]++;
+  session->bulletGraceTicks = BULLET_GRACE_TICKS;
+}
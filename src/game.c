@@ -0,0 +1,194 @@
+#include "game.h"
+#include "gamedata.h"
+#include "profile.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Load the shared archetype and wave tables. Call once, before any session
+// is created; returns false if the game data table cannot be read.
+bool game_init(void) {
+  if (!gamedata_load(GAMEDATA_PATH)) {
+    return false;
+  }
+  bullet_init();
+  return true;
+}
+
+GameSession *game_session_create(unsigned int seed) {
+  return game_session_create_capacity(seed, MAX_PARTICLES);
+}
+
+// A session whose particle systems each hold up to capacity particles
+GameSession *game_session_create_capacity(unsigned int seed, int capacity) {
+  GameSession *session = malloc(sizeof(GameSession));
+  particle_system_init(&session->enemies, capacity, 20);
+  particle_system_init(&session->bosses, capacity, 5);
+  particle_system_init(&session->powerups, capacity, 10);
+  particle_system_init(&session->projectiles, capacity, 1);
+  bullet_pool_init(&session->bullets, MAX_BULLETS);
+  collision_grid_init(&session->grid, 2 * capacity);
+  game_session_reset(session, seed);
+  return session;
+}
+
+// Put a session back to the start of a game
+void game_session_reset(GameSession *session, unsigned int seed) {
+  const Archetype *a = &archetypes[ARCHETYPE_SHARK];
+  particle_system_reset(&session->enemies);
+  particle_system_reset(&session->bosses);
+  particle_system_reset(&session->powerups);
+  particle_system_reset(&session->projectiles);
+  bullet_pool_reset(&session->bullets);
+  session->shark.x = SCREEN_WIDTH / 2 - a->frameWidth / 2;
+  session->shark.prevX = session->shark.x;
+  session->shark.y = SCREEN_HEIGHT - a->frameHeight - 20;
+  session->shark.health = a->health;
+  session->bulletGraceTicks = 0;
+  session->sharkAcceleration = 0;
+  session->projectileInterval = 1.0;
+  session->tick = 0;
+  session->score = 0;
+  session->nextPatternTime = 0;
+  session->lastInterval = 0;
+  memset(session->damageBy, 0, sizeof(session->damageBy));
+  memset(session->events, 0, sizeof(session->events));
+  game_seed(session, seed);
+}
+
+void game_session_free(GameSession *session) {
+  particle_system_free(&session->enemies);
+  particle_system_free(&session->bosses);
+  particle_system_free(&session->powerups);
+  particle_system_free(&session->projectiles);
+  bullet_pool_free(&session->bullets);
+  collision_grid_free(&session->grid);
+  free(session);
+}
+
+bool game_over(const GameSession *session) {
+  return session->shark.health <= 0;
+}
+
+// Advance the world by one fixed step. Everything that changes game state
+// happens here, so the cost of a tick does not depend on the render rate.
+void simulation_tick(GameSession *session, unsigned int input) {
+  unsigned long count = ++session->tick;
+  memset(session->events, 0, sizeof(session->events));
+  if (count % 20 == 0) {
+    session->score++;
+  }
+  uint64_t start = profile_begin();
+  particle_queue_pattern(session);
+  profile_end(PROFILE_PATTERN, start);
+
+  start = profile_begin();
+  particle_update_system(&session->enemies);
+  particle_update_system(&session->bosses);
+  particle_update_system(&session->powerups);
+  particle_spawn_projectiles(session);
+  particle_update_system(&session->projectiles);
+  bullet_pool_update(&session->bullets);
+  boss_emit_bullets(session);
+  session->shark.prevX = session->shark.x;
+  parse_input(session, input);
+  profile_end(PROFILE_UPDATE, start);
+
+  start = profile_begin();
+  collision_grid_build(&session->grid, &session->enemies, &session->powerups);
+  player_particle_collision(session);
+  player_projectile_collision(session);
+  player_bullet_collision(session);
+  profile_end(PROFILE_COLLISION, start);
+}
+
+static uint32_t checksum_int(uint32_t hash, int value) {
+  // FNV-1a over the four bytes of the value, low byte first
+  for (int b = 0; b < 4; b++) {
+    hash ^= ((uint32_t)value >> (b * 8)) & 0xFF;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t checksum_system(uint32_t hash, const ParticleSystem *system) {
+  hash = checksum_int(hash, system->count);
+  for (int k = 0; k < system->count; k++) {
+    int i = system->alive[k];
+    hash = checksum_int(hash, system->archetype[i]);
+    hash = checksum_int(hash, system->x[i]);
+    hash = checksum_int(hash, system->y[i]);
+    hash = checksum_int(hash, system->health[i]);
+  }
+  return hash;
+}
+
+// Hash of the state that decides how the game plays out. Two sessions given
+// the same seed and input must agree on it after every tick.
+uint32_t game_checksum(const GameSession *session) {
+  uint32_t hash = 2166136261u;
+  hash = checksum_int(hash, (int)session->tick);
+  hash = checksum_int(hash, (int)session->score);
+  hash = checksum_int(hash, session->shark.x);
+  hash = checksum_int(hash, session->shark.health);
+  hash = checksum_int(hash, session->bulletGraceTicks);
+  hash = checksum_int(hash, (int)session->rngState);
+  hash = checksum_int(hash, (int)(session->rngState >> 32));
+  hash = checksum_system(hash, &session->enemies);
+  hash = checksum_system(hash, &session->bosses);
+  hash = checksum_system(hash, &session->powerups);
+  hash = checksum_system(hash, &session->projectiles);
+  hash = checksum_int(hash, session->bullets.count);
+  for (int i = 0; i < session->bullets.count; i++) {
+    hash = checksum_int(hash, session->bullets.x[i]);
+    hash = checksum_int(hash, session->bullets.y[i]);
+  }
+  return hash;
+}
+
+void parse_input(GameSession *session, unsigned int input) {
+  Player *shark = &session->shark;
+  double *acceleration = &session->sharkAcceleration;
+  bool left = input & INPUT_LEFT;
+  bool right = input & INPUT_RIGHT;
+  if (right && shark->x + 1 + (20 * *acceleration) < 482 && !left) {
+    if (*acceleration < 0) {
+      *acceleration = 0;
+    }
+    shark->x += 1 + (20 * *acceleration);
+    *acceleration += 0.005;
+  } else if (left && shark->x + -1 + (20 * *acceleration) > 130 && !right) {
+    if (*acceleration > 0) {
+      *acceleration = 0;
+    }
+    shark->x += -1 + (20 * *acceleration);
+    *acceleration -= 0.005;
+  } else {
+    *acceleration = 0;
+  }
+}
+
+static uint32_t game_random_next(GameSession *session) {
+  uint64_t old = session->rngState;
+  session->rngState = old * 6364136223846793005ULL + 1442695040888963407ULL;
+  uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+  uint32_t rot = (uint32_t)(old >> 59u);
+  return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+void game_seed(GameSession *session, unsigned int seed) {
+  session->rngState = 0;
+  game_random_next(session);
+  session->rngState += seed;
+  game_random_next(session);
+}
+
+// Random integer in [min, max], both inclusive, like raylib's GetRandomValue
+int game_random(GameSession *session, int min, int max) {
+  if (min > max) {
+    int tmp = max;
+    max = min;
+    min = tmp;
+  }
+  return min +
+         (int)(game_random_next(session) % ((unsigned int)(max - min) + 1));
+}
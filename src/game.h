@@ -0,0 +1,330 @@
+#ifndef GAME_H
+#define GAME_H
+
+// Game simulation shared by the windowed game and the headless tools. Nothing
+// in here depends on raylib: rendering, audio and input polling live in the
+// front ends, which feed the simulation one tick and one input word at a time.
+
+#include "log.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Default pool size of each particle system in a session
+#define MAX_PARTICLES 500
+#define SCREEN_WIDTH 640
+#define SCREEN_HEIGHT 960
+// The simulation always advances in fixed 1/TICK_RATE steps; rendering runs
+// at whatever rate the display allows and interpolates between ticks.
+#define TICK_RATE 60
+
+typedef enum {
+  ENEMY = 0,
+  POWER_UP_HEALTH = 1,
+  POWER_UP_INVIS = 2,
+  POWER_UP_DOUBLE_FIRE_DAMAGE = 4,
+  POWER_UP_DOUBLE_ENEMY_DAMAGE = 8,
+  POWER_UP_SPREAD = 16,
+  BOX = 32,
+  PROJECTILE = 64,
+  BOSS_ORCA = 128,
+  BOSS_EEL = 256,
+  BOSS_KRAKEN = 512,
+  ENEMY_RINGS = 1024,
+  ENEMY_OIL = 2048,
+  ENEMY_STRAW = 4096,
+  ENEMY_JELLYFISH = 4096 * 2,
+  ENEMY_ANCHOR = 4096 * 4,
+  GAP = 4096 * 8,
+  POWERUP = 4096 * 16,
+  CHARACTER_PROJECTILE = 4096 * 32,
+  BOSS_PROJECTILE = 4096 * 64,
+} ParticleType;
+
+// Per-kind data shared by every particle of that kind. The powerup, enemy and
+// boss entries are in the order the pattern spawner indexes them.
+typedef enum {
+  ARCHETYPE_CRATE = 0,
+  ARCHETYPE_CAKE,
+  ARCHETYPE_COCONUT,
+  ARCHETYPE_MANGO,
+  ARCHETYPE_SODA,
+  ARCHETYPE_TEA,
+  ARCHETYPE_STRAW,
+  ARCHETYPE_RINGS,
+  ARCHETYPE_ANCHOR,
+  ARCHETYPE_JELLYFISH,
+  ARCHETYPE_OILSPILL,
+  ARCHETYPE_ORCA,
+  ARCHETYPE_EEL,
+  ARCHETYPE_KRAKEN,
+  ARCHETYPE_HARPOON,
+  ARCHETYPE_SHARK,
+  ARCHETYPE_COUNT
+} ArchetypeId;
+
+// How a boss fires. Every period ticks of its life it emits a volley of
+// count bullets at speed (fixed point, see BULLET_SHIFT):
+//   RADIAL  evenly spaced around a full circle
+//   AIMED   fanned over angle degrees, centred on the shark
+//   SPIRAL  evenly spaced around a full circle, each volley turned a further
+//           angle degrees
+typedef enum {
+  EMITTER_NONE = 0,
+  EMITTER_RADIAL,
+  EMITTER_AIMED,
+  EMITTER_SPIRAL
+} EmitterPattern;
+
+typedef struct {
+  EmitterPattern pattern;
+  unsigned int period;
+  int count;
+  int speed;
+  int angle;
+} Emitter;
+
+typedef struct {
+  int w;
+  int h;
+  int frameWidth;
+  int frameHeight;
+  unsigned int numberOfFrames;
+  // ticks each animation frame is shown for
+  unsigned int frameTicks;
+  int dy;
+  int health;
+  ParticleType type;
+  Emitter emitter;
+} Archetype;
+
+// Particles are stored as one array per hot field, indexed by slot. Anything
+// that is the same for every particle of a kind lives in archetypes[] and is
+// reached through archetype[slot]. The arrays hold capacity slots and are
+// allocated once by particle_system_init.
+typedef struct {
+  int *x;
+  int *y;
+  int *dy;
+  int *health;
+  ParticleType *type;
+  // tick the particle spawned on; its animation frame is derived from this
+  // and the session tick when it is drawn
+  unsigned long *phase;
+  unsigned char *archetype;
+  bool *isAlive;
+  // slot indices of the live particles, packed into alive[0..count)
+  int *alive;
+  // stack of unused slot indices, popped on spawn and pushed on sweep
+  int *freeSlots;
+  int freeCount;
+  int speed;
+  int count;
+  int capacity;
+} ParticleSystem;
+
+typedef struct {
+  int x;
+  int y;
+  // x at the start of the current tick, for interpolated drawing
+  int prevX;
+  int health;
+} Player;
+
+// Waves are rows of PATTERN_COLUMNS cells spawned across the playfield, one
+// row for a single-line wave and PATTERN_ROWS for a multi-line one. A cell is
+// a gap, a random enemy, a random powerup, or PATTERN_ARCHETYPE plus the id
+// of a boss archetype, ARCHETYPE_ORCA to ARCHETYPE_KRAKEN.
+#define PATTERN_COLUMNS 12
+#define PATTERN_ROWS 3
+// Screen column of a wave's first cell, in 32 pixel columns
+#define PATTERN_FIRST_COLUMN 4
+#define MAX_PATTERNS 32
+
+enum {
+  PATTERN_GAP = 0,
+  PATTERN_ENEMY,
+  PATTERN_POWERUP,
+  PATTERN_ARCHETYPE
+};
+
+typedef struct {
+  // single-line waves only use the first row
+  unsigned char cells[PATTERN_ROWS][PATTERN_COLUMNS];
+} WavePattern;
+
+typedef struct {
+  WavePattern single[MAX_PATTERNS];
+  int singleCount;
+  WavePattern multi[MAX_PATTERNS];
+  int multiCount;
+} WaveTable;
+
+// Boss bullets, kept apart from the particle systems because there can be
+// thousands of them. Positions and velocities are fixed point with
+// BULLET_SHIFT fractional bits, so moving the whole pool is a run of integer
+// adds the compiler can vectorise, and it comes out the same on every build.
+// Bullets have no identity: the pool is kept packed in [0, count) and dead
+// bullets are compacted away at once.
+#define MAX_BULLETS 10000
+#define BULLET_SHIFT 8
+#define BULLET_RADIUS 4
+// Ticks after a bullet hit in which bullets pass through the shark
+#define BULLET_GRACE_TICKS 90
+
+typedef struct {
+  int *x;
+  int *y;
+  int *vx;
+  int *vy;
+  // archetype of the boss that fired it
+  unsigned char *owner;
+  // scratch for collision: indices of the bullets that passed the coarse test
+  int *candidates;
+  int count;
+  int capacity;
+} BulletPool;
+
+// Uniform grid over the playfield used as the collision broadphase. Each live
+// particle is bucketed by the cell holding its top-left corner; queries widen
+// their search by the largest particle seen so that nothing straddling a cell
+// border is missed. Entries are stored in cell order together with their
+// packed bounds, so one row of cells is a contiguous run that the batched
+// AABB kernel can test in a single call.
+#define GRID_CELL_SIZE 64
+#define GRID_COLS (SCREEN_WIDTH / GRID_CELL_SIZE)
+#define GRID_ROWS (SCREEN_HEIGHT / GRID_CELL_SIZE)
+#define GRID_CELLS (GRID_COLS * GRID_ROWS)
+
+typedef enum { GRID_ENEMY = 0, GRID_POWERUP, GRID_LAYERS } GridLayer;
+
+// A handle names one particle of one layer
+#define GRID_HANDLE(layer, slot) ((slot) * GRID_LAYERS + (layer))
+#define GRID_HANDLE_LAYER(handle) ((handle) % GRID_LAYERS)
+#define GRID_HANDLE_SLOT(handle) ((handle) / GRID_LAYERS)
+
+typedef struct {
+  ParticleSystem *layers[GRID_LAYERS];
+  // entries of cell c are handles[cellStart[c]..cellStart[c + 1])
+  int cellStart[GRID_CELLS + 1];
+  // per-entry arrays, room for capacity entries
+  int *handles;
+  int *minX;
+  int *minY;
+  int *maxX;
+  int *maxY;
+  // scratch for queries: the kernel's hit mask and the handles found
+  uint32_t *hitMask;
+  int *results;
+  int capacity;
+  int maxWidth;
+  int maxHeight;
+} CollisionGrid;
+
+// Input for one tick, sampled by the front end
+typedef enum { INPUT_LEFT = 1, INPUT_RIGHT = 2 } InputBits;
+
+// Things the front end may want to play a sound for
+typedef enum {
+  GAME_EVENT_FIRE = 0,
+  GAME_EVENT_CRATE_HIT,
+  GAME_EVENT_PICKUP,
+  GAME_EVENT_HURT,
+  GAME_EVENT_COUNT
+} GameEvent;
+
+// Everything that changes while a game is played. Sessions share nothing
+// mutable, so several of them can run side by side on different threads.
+typedef struct {
+  ParticleSystem enemies;
+  ParticleSystem bosses;
+  ParticleSystem powerups;
+  ParticleSystem projectiles;
+  BulletPool bullets;
+  CollisionGrid grid;
+  Player shark;
+  // ticks left before bullets can hurt the shark again
+  int bulletGraceTicks;
+  double sharkAcceleration;
+  double projectileInterval; // in seconds
+  unsigned long tick;
+  unsigned long score;
+  unsigned long nextPatternTime;
+  unsigned int lastInterval;
+  // PCG32 state for every random choice the simulation makes, so a session
+  // is fully determined by its seed and its input
+  uint64_t rngState;
+  // hits taken by the shark, by the archetype that dealt them
+  unsigned int damageBy[ARCHETYPE_COUNT];
+  // how often each event happened in the last tick; output only, so it is
+  // left out of checksums and snapshots
+  unsigned int events[GAME_EVENT_COUNT];
+} GameSession;
+
+// Read-only once game_init has run; shared by all sessions
+extern Archetype archetypes[ARCHETYPE_COUNT];
+extern WaveTable waves;
+
+// game.c
+bool game_init(void);
+GameSession *game_session_create(unsigned int seed);
+GameSession *game_session_create_capacity(unsigned int seed, int capacity);
+void game_session_reset(GameSession *session, unsigned int seed);
+void game_session_free(GameSession *session);
+bool game_over(const GameSession *session);
+void simulation_tick(GameSession *session, unsigned int input);
+uint32_t game_checksum(const GameSession *session);
+void parse_input(GameSession *session, unsigned int input);
+void game_seed(GameSession *session, unsigned int seed);
+int game_random(GameSession *session, int min, int max);
+
+// particle.c
+void particle_system_init(ParticleSystem *system, int capacity, int speed);
+void particle_system_reset(ParticleSystem *system);
+void particle_system_free(ParticleSystem *system);
+int particle_system_acquire(ParticleSystem *system);
+void particle_system_sweep(ParticleSystem *system);
+int particle_system_spawn(ParticleSystem *system, int archetype, int x, int y,
+                          unsigned long tick);
+void particle_update_system(ParticleSystem *system);
+unsigned int archetype_frame(const Archetype *a, unsigned long tick,
+                             unsigned long phase);
+int particle_boss_system_create_particle(ParticleSystem *system,
+                                         int particleType, int x,
+                                         unsigned long tick);
+int particle_power_system_create_particle(ParticleSystem *system,
+                                          int particleType, int x,
+                                          unsigned long tick);
+int particle_enemy_system_create_particle(ParticleSystem *system,
+                                          int particleType, int x,
+                                          unsigned long tick);
+void particle_spawn_projectiles(GameSession *session);
+
+// bullet.c
+void bullet_init(void);
+void bullet_pool_init(BulletPool *pool, int capacity);
+void bullet_pool_reset(BulletPool *pool);
+void bullet_pool_free(BulletPool *pool);
+bool bullet_pool_spawn(BulletPool *pool, int x, int y, int vx, int vy,
+                       int owner);
+void bullet_pool_update(BulletPool *pool);
+int bullet_pool_hit(BulletPool *pool, int x, int y, int w, int h,
+                    unsigned int *damageBy);
+void bullet_direction(int degrees, int speed, int *vx, int *vy);
+void boss_emit_bullets(GameSession *session);
+
+// pattern.c
+void particle_queue_pattern(GameSession *session);
+int interval(GameSession *session, unsigned long frameCount, const int fps);
+
+// collision.c
+void collision_grid_init(CollisionGrid *grid, int capacity);
+void collision_grid_free(CollisionGrid *grid);
+void collision_grid_build(CollisionGrid *grid, ParticleSystem *enemy,
+                          ParticleSystem *powerup);
+int collision_grid_query(CollisionGrid *grid, int x, int y, int w, int h,
+                         int layerMask, int *out, int maxOut);
+void player_particle_collision(GameSession *session);
+void player_projectile_collision(GameSession *session);
+void player_bullet_collision(GameSession *session);
+
+#endif
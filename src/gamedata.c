@@ -0,0 +1,238 @@
+#include "gamedata.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GAMEDATA_HEADER_SIZE 16
+#define GAMEDATA_ARCHETYPE_SIZE 53
+#define GAMEDATA_MAX_SIZE                                                      \
+  (GAMEDATA_HEADER_SIZE + ARCHETYPE_COUNT * GAMEDATA_ARCHETYPE_SIZE +          \
+   MAX_PATTERNS * PATTERN_COLUMNS +                                            \
+   MAX_PATTERNS * PATTERN_ROWS * PATTERN_COLUMNS)
+
+const char *const archetypeNames[ARCHETYPE_COUNT] = {
+    [ARCHETYPE_CRATE] = "crate",         [ARCHETYPE_CAKE] = "cake",
+    [ARCHETYPE_COCONUT] = "coconut",     [ARCHETYPE_MANGO] = "mango",
+    [ARCHETYPE_SODA] = "soda",           [ARCHETYPE_TEA] = "tea",
+    [ARCHETYPE_STRAW] = "straw",         [ARCHETYPE_RINGS] = "rings",
+    [ARCHETYPE_ANCHOR] = "anchor",       [ARCHETYPE_JELLYFISH] = "jellyfish",
+    [ARCHETYPE_OILSPILL] = "oilspill",   [ARCHETYPE_ORCA] = "orca",
+    [ARCHETYPE_EEL] = "eel",             [ARCHETYPE_KRAKEN] = "kraken",
+    [ARCHETYPE_HARPOON] = "harpoon",     [ARCHETYPE_SHARK] = "shark",
+};
+
+static bool check_pattern(const WavePattern *pattern, int rows,
+                          const char *kind, int index, char *error,
+                          size_t errorSize) {
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < PATTERN_COLUMNS; c++) {
+      int cell = pattern->cells[r][c];
+      // named cells spawn into the boss system, so only bosses may be named
+      if (cell >= PATTERN_ARCHETYPE &&
+          (cell < PATTERN_ARCHETYPE + ARCHETYPE_ORCA ||
+           cell > PATTERN_ARCHETYPE + ARCHETYPE_KRAKEN)) {
+        snprintf(error, errorSize,
+                 "%s wave %d row %d column %d: cell %d is not a boss", kind,
+                 index, r, c, cell);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool gamedata_check(const GameData *data, char *error, size_t errorSize) {
+  for (int a = 0; a < ARCHETYPE_COUNT; a++) {
+    const Archetype *archetype = &data->archetypes[a];
+    const Emitter *e = &archetype->emitter;
+    const char *name = archetypeNames[a];
+    if (archetype->numberOfFrames == 0 || archetype->frameTicks == 0) {
+      snprintf(error, errorSize, "%s: frames and frameTicks must be set",
+               name);
+      return false;
+    }
+    if (archetype->frameWidth <= 0 || archetype->frameHeight <= 0) {
+      snprintf(error, errorSize, "%s: frame size must be set", name);
+      return false;
+    }
+    if (archetype->health <= 0) {
+      snprintf(error, errorSize, "%s: health must be positive", name);
+      return false;
+    }
+    // particles are only removed below the screen, or above it for
+    // projectiles; the shark is not a particle
+    bool projectile = archetype->type == PROJECTILE;
+    if (a != ARCHETYPE_SHARK &&
+        (archetype->dy == 0 || (archetype->dy < 0 && !projectile))) {
+      snprintf(error, errorSize, "%s: dy %d never leaves the screen", name,
+               archetype->dy);
+      return false;
+    }
+    if (e->pattern > EMITTER_SPIRAL) {
+      snprintf(error, errorSize, "%s: unknown emitter %d", name, e->pattern);
+      return false;
+    }
+    if (e->pattern != EMITTER_NONE &&
+        (e->period == 0 || e->count <= 0 || e->count > 360)) {
+      snprintf(error, errorSize,
+               "%s: an emitter needs a period and 1 to 360 bullets", name);
+      return false;
+    }
+  }
+  if (data->waves.singleCount < 1 || data->waves.singleCount > MAX_PATTERNS ||
+      data->waves.multiCount < 1 || data->waves.multiCount > MAX_PATTERNS) {
+    snprintf(error, errorSize,
+             "there must be 1 to %d single-line and multi-line waves",
+             MAX_PATTERNS);
+    return false;
+  }
+  for (int p = 0; p < data->waves.singleCount; p++) {
+    if (!check_pattern(&data->waves.single[p], 1, "single-line", p, error,
+                       errorSize)) {
+      return false;
+    }
+  }
+  for (int p = 0; p < data->waves.multiCount; p++) {
+    if (!check_pattern(&data->waves.multi[p], PATTERN_ROWS, "multi-line", p,
+                       error, errorSize)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t gamedata_size(const GameData *data) {
+  return GAMEDATA_HEADER_SIZE + ARCHETYPE_COUNT * GAMEDATA_ARCHETYPE_SIZE +
+         data->waves.singleCount * PATTERN_COLUMNS +
+         data->waves.multiCount * PATTERN_ROWS * PATTERN_COLUMNS;
+}
+
+static unsigned char *put(unsigned char *out, uint32_t value, int bytes) {
+  for (int b = 0; b < bytes; b++) {
+    out[b] = (value >> (b * 8)) & 0xFF;
+  }
+  return out + bytes;
+}
+
+static uint32_t get(const unsigned char **in, int bytes) {
+  uint32_t value = 0;
+  for (int b = 0; b < bytes; b++) {
+    value |= (uint32_t)(*in)[b] << (b * 8);
+  }
+  *in += bytes;
+  return value;
+}
+
+void gamedata_encode(const GameData *data, unsigned char *out) {
+  memcpy(out, "SSGD", 4);
+  unsigned char *p = put(out + 4, GAMEDATA_VERSION, 2);
+  p = put(p, ARCHETYPE_COUNT, 2);
+  p = put(p, PATTERN_COLUMNS, 2);
+  p = put(p, PATTERN_ROWS, 2);
+  p = put(p, data->waves.singleCount, 2);
+  p = put(p, data->waves.multiCount, 2);
+  for (int i = 0; i < ARCHETYPE_COUNT; i++) {
+    const Archetype *a = &data->archetypes[i];
+    p = put(p, a->w, 4);
+    p = put(p, a->h, 4);
+    p = put(p, a->frameWidth, 4);
+    p = put(p, a->frameHeight, 4);
+    p = put(p, a->numberOfFrames, 4);
+    p = put(p, a->frameTicks, 4);
+    p = put(p, a->dy, 4);
+    p = put(p, a->health, 4);
+    p = put(p, a->type, 4);
+    p = put(p, a->emitter.pattern, 1);
+    p = put(p, a->emitter.period, 4);
+    p = put(p, a->emitter.count, 4);
+    p = put(p, a->emitter.speed, 4);
+    p = put(p, a->emitter.angle, 4);
+  }
+  for (int i = 0; i < data->waves.singleCount; i++) {
+    memcpy(p, data->waves.single[i].cells[0], PATTERN_COLUMNS);
+    p += PATTERN_COLUMNS;
+  }
+  for (int i = 0; i < data->waves.multiCount; i++) {
+    memcpy(p, data->waves.multi[i].cells, PATTERN_ROWS * PATTERN_COLUMNS);
+    p += PATTERN_ROWS * PATTERN_COLUMNS;
+  }
+}
+
+static bool gamedata_decode(GameData *data, const unsigned char *in,
+                            size_t size) {
+  if (size < GAMEDATA_HEADER_SIZE || memcmp(in, "SSGD", 4) != 0) {
+    return false;
+  }
+  const unsigned char *p = in + 4;
+  uint32_t version = get(&p, 2);
+  uint32_t archetypeCount = get(&p, 2);
+  uint32_t columns = get(&p, 2);
+  uint32_t rows = get(&p, 2);
+  uint32_t singleCount = get(&p, 2);
+  uint32_t multiCount = get(&p, 2);
+  if (version != GAMEDATA_VERSION || archetypeCount != ARCHETYPE_COUNT ||
+      columns != PATTERN_COLUMNS || rows != PATTERN_ROWS ||
+      singleCount > MAX_PATTERNS || multiCount > MAX_PATTERNS) {
+    return false;
+  }
+  memset(data, 0, sizeof(GameData));
+  data->waves.singleCount = singleCount;
+  data->waves.multiCount = multiCount;
+  if (size != gamedata_size(data)) {
+    return false;
+  }
+  for (int i = 0; i < ARCHETYPE_COUNT; i++) {
+    Archetype *a = &data->archetypes[i];
+    a->w = (int32_t)get(&p, 4);
+    a->h = (int32_t)get(&p, 4);
+    a->frameWidth = (int32_t)get(&p, 4);
+    a->frameHeight = (int32_t)get(&p, 4);
+    a->numberOfFrames = get(&p, 4);
+    a->frameTicks = get(&p, 4);
+    a->dy = (int32_t)get(&p, 4);
+    a->health = (int32_t)get(&p, 4);
+    a->type = (ParticleType)get(&p, 4);
+    a->emitter.pattern = (EmitterPattern)get(&p, 1);
+    a->emitter.period = get(&p, 4);
+    a->emitter.count = (int32_t)get(&p, 4);
+    a->emitter.speed = (int32_t)get(&p, 4);
+    a->emitter.angle = (int32_t)get(&p, 4);
+  }
+  for (uint32_t i = 0; i < singleCount; i++) {
+    memcpy(data->waves.single[i].cells[0], p, PATTERN_COLUMNS);
+    p += PATTERN_COLUMNS;
+  }
+  for (uint32_t i = 0; i < multiCount; i++) {
+    memcpy(data->waves.multi[i].cells, p, PATTERN_ROWS * PATTERN_COLUMNS);
+    p += PATTERN_ROWS * PATTERN_COLUMNS;
+  }
+  return true;
+}
+
+bool gamedata_load(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    game_log(GAME_LOG_WARNING, "GAMEDATA: Could not open %s\n", path);
+    return false;
+  }
+  // one read into a buffer that fits the largest table; anything longer
+  // fails the size check
+  unsigned char buffer[GAMEDATA_MAX_SIZE + 1];
+  size_t size = fread(buffer, 1, sizeof(buffer), file);
+  fclose(file);
+
+  GameData data;
+  char error[256];
+  if (!gamedata_decode(&data, buffer, size)) {
+    game_log(GAME_LOG_WARNING,
+             "GAMEDATA: %s is not a game data table for this build\n", path);
+    return false;
+  }
+  if (!gamedata_check(&data, error, sizeof(error))) {
+    game_log(GAME_LOG_WARNING, "GAMEDATA: %s: %s\n", path, error);
+    return false;
+  }
+  memcpy(archetypes, data.archetypes, sizeof(archetypes));
+  waves = data.waves;
+  return true;
+}
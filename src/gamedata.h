@@ -0,0 +1,41 @@
+#ifndef GAMEDATA_H
+#define GAMEDATA_H
+
+// The archetype and wave tables, kept out of the code. Designers edit
+// src/assets/data/gamedata.txt; the gameDataBuild step checks it and packs it
+// into gamedata.bin, which game_init reads in one go with no parsing.
+//
+// gamedata.bin layout, all integers little-endian:
+//   "SSGD"  u16 version  u16 archetypes  u16 columns  u16 rows
+//   u16 single-line waves  u16 multi-line waves
+//   per archetype, in ArchetypeId order:
+//     i32 w, h, frameWidth, frameHeight  u32 numberOfFrames, frameTicks
+//     i32 dy, health  u32 type
+//     u8 emitter pattern  u32 period  i32 count, speed, angle
+//   per single-line wave: columns cells, one byte each
+//   per multi-line wave: rows * columns cells, row by row
+
+#include "game.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#define GAMEDATA_VERSION 1
+
+typedef struct {
+  Archetype archetypes[ARCHETYPE_COUNT];
+  WaveTable waves;
+} GameData;
+
+// Lower-case name of each archetype, as the text source and reports use it
+extern const char *const archetypeNames[ARCHETYPE_COUNT];
+
+// Check the values the simulation relies on. Returns false and describes the
+// first problem in error otherwise.
+bool gamedata_check(const GameData *data, char *error, size_t errorSize);
+// Bytes gamedata_encode writes for data
+size_t gamedata_size(const GameData *data);
+void gamedata_encode(const GameData *data, unsigned char *out);
+// Read a packed table into the shared archetypes[] and waves
+bool gamedata_load(const char *path);
+
+#endif
@@ -0,0 +1,296 @@
+// Build step for the game data table. Reads the text source of the
+// archetypes and waves, checks it and writes the packed table game_init
+// loads (see gamedata.h).
+//
+//   gameDataBuild SOURCE OUT
+//   gameDataBuild --check SOURCE
+//
+// --check only validates the source, for designers trying out a change.
+// Errors name the source line and the build fails on any of them.
+#include "gamedata.h"
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE 1024
+#define MAX_TOKENS 64
+
+typedef struct {
+  const char *name;
+  int value;
+} NamedValue;
+
+static const NamedValue typeNames[] = {
+    {"ENEMY", ENEMY},
+    {"POWER_UP_HEALTH", POWER_UP_HEALTH},
+    {"POWER_UP_INVIS", POWER_UP_INVIS},
+    {"POWER_UP_DOUBLE_FIRE_DAMAGE", POWER_UP_DOUBLE_FIRE_DAMAGE},
+    {"POWER_UP_DOUBLE_ENEMY_DAMAGE", POWER_UP_DOUBLE_ENEMY_DAMAGE},
+    {"POWER_UP_SPREAD", POWER_UP_SPREAD},
+    {"BOX", BOX},
+    {"PROJECTILE", PROJECTILE},
+};
+
+static const NamedValue emitterNames[] = {
+    {"none", EMITTER_NONE},
+    {"radial", EMITTER_RADIAL},
+    {"aimed", EMITTER_AIMED},
+    {"spiral", EMITTER_SPIRAL},
+};
+
+static const char *sourcePath;
+static int lineNumber;
+
+static void fail(const char *message, const char *detail) {
+  fprintf(stderr, "%s:%d: %s%s%s\n", sourcePath, lineNumber, message,
+          detail ? ": " : "", detail ? detail : "");
+  exit(1);
+}
+
+static int archetype_id(const char *name) {
+  for (int a = 0; a < ARCHETYPE_COUNT; a++) {
+    if (strcmp(archetypeNames[a], name) == 0) {
+      return a;
+    }
+  }
+  return -1;
+}
+
+static int named_value(const NamedValue *table, int count, const char *name,
+                       const char *what) {
+  for (int i = 0; i < count; i++) {
+    if (strcmp(table[i].name, name) == 0) {
+      return table[i].value;
+    }
+  }
+  fail(what, name);
+  return 0;
+}
+
+static long parse_int(const char *text) {
+  char *end;
+  errno = 0;
+  long value = strtol(text, &end, 10);
+  if (*text == '\0' || *end != '\0' || errno != 0) {
+    fail("not a whole number", text);
+  }
+  return value;
+}
+
+static void parse_size(const char *text, int *w, int *h) {
+  char *end;
+  errno = 0;
+  long width = strtol(text, &end, 10);
+  if (end == text || *end != 'x' || errno != 0 || width < INT_MIN ||
+      width > INT_MAX) {
+    fail("sizes are written WxH", text);
+  }
+  long height = parse_int(end + 1);
+  if (height < INT_MIN || height > INT_MAX) {
+    fail("sizes are written WxH", text);
+  }
+  *w = (int)width;
+  *h = (int)height;
+}
+
+// Apply one key=value token to an archetype
+static void parse_field(Archetype *a, char *token) {
+  char *value = strchr(token, '=');
+  if (value == NULL) {
+    fail("expected key=value", token);
+  }
+  *value++ = '\0';
+  if (strcmp(token, "size") == 0) {
+    parse_size(value, &a->w, &a->h);
+  } else if (strcmp(token, "frame") == 0) {
+    parse_size(value, &a->frameWidth, &a->frameHeight);
+  } else if (strcmp(token, "frames") == 0) {
+    a->numberOfFrames = (unsigned int)parse_int(value);
+  } else if (strcmp(token, "frameTicks") == 0) {
+    a->frameTicks = (unsigned int)parse_int(value);
+  } else if (strcmp(token, "dy") == 0) {
+    a->dy = (int)parse_int(value);
+  } else if (strcmp(token, "health") == 0) {
+    a->health = (int)parse_int(value);
+  } else if (strcmp(token, "type") == 0) {
+    int type = 0;
+    for (char *flag = strtok(value, "|"); flag; flag = strtok(NULL, "|")) {
+      type |= named_value(typeNames, sizeof(typeNames) / sizeof(NamedValue),
+                          flag, "unknown type flag");
+    }
+    a->type = (ParticleType)type;
+  } else if (strcmp(token, "emitter") == 0) {
+    a->emitter.pattern = (EmitterPattern)named_value(
+        emitterNames, sizeof(emitterNames) / sizeof(NamedValue), value,
+        "unknown emitter");
+  } else if (strcmp(token, "period") == 0) {
+    a->emitter.period = (unsigned int)parse_int(value);
+  } else if (strcmp(token, "count") == 0) {
+    a->emitter.count = (int)parse_int(value);
+  } else if (strcmp(token, "speed") == 0) {
+    // pixels per tick in the source, fixed point in the table
+    char *end;
+    double speed = strtod(value, &end);
+    if (*end != '\0') {
+      fail("not a number", value);
+    }
+    a->emitter.speed = (int)lround(speed * (1 << BULLET_SHIFT));
+  } else if (strcmp(token, "angle") == 0) {
+    a->emitter.angle = (int)parse_int(value);
+  } else {
+    fail("unknown archetype field", token);
+  }
+}
+
+static void parse_row(unsigned char *cells, char **tokens, int count) {
+  if (count > PATTERN_COLUMNS) {
+    char detail[64];
+    snprintf(detail, sizeof(detail), "column %d of %d", count,
+             PATTERN_COLUMNS);
+    fail("wave row runs past the last column", detail);
+  }
+  if (count < PATTERN_COLUMNS) {
+    char detail[64];
+    snprintf(detail, sizeof(detail), "%d of %d", count, PATTERN_COLUMNS);
+    fail("wave row is missing columns", detail);
+  }
+  for (int c = 0; c < count; c++) {
+    if (strcmp(tokens[c], ".") == 0) {
+      cells[c] = PATTERN_GAP;
+    } else if (strcmp(tokens[c], "E") == 0) {
+      cells[c] = PATTERN_ENEMY;
+    } else if (strcmp(tokens[c], "P") == 0) {
+      cells[c] = PATTERN_POWERUP;
+    } else {
+      int a = archetype_id(tokens[c]);
+      if (a < 0) {
+        fail("unknown wave cell", tokens[c]);
+      }
+      cells[c] = PATTERN_ARCHETYPE + a;
+    }
+  }
+}
+
+static void parse_source(FILE *file, GameData *data) {
+  bool defined[ARCHETYPE_COUNT] = {false};
+  Archetype *current = NULL;
+  WavePattern *wave = NULL;
+  int rowsLeft = 0;
+  int row = 0;
+  char line[MAX_LINE];
+  while (fgets(line, sizeof(line), file) != NULL) {
+    lineNumber++;
+    char *comment = strchr(line, '#');
+    if (comment != NULL) {
+      *comment = '\0';
+    }
+    bool continuation = line[0] == ' ' || line[0] == '\t';
+    char *tokens[MAX_TOKENS];
+    int count = 0;
+    for (char *t = strtok(line, " \t\r\n"); t; t = strtok(NULL, " \t\r\n")) {
+      if (count == MAX_TOKENS) {
+        fail("line has too many fields", NULL);
+      }
+      tokens[count++] = t;
+    }
+    if (count == 0) {
+      continue;
+    }
+
+    if (rowsLeft > 0) {
+      parse_row(wave->cells[row++], tokens, count);
+      rowsLeft--;
+    } else if (continuation && current != NULL) {
+      for (int t = 0; t < count; t++) {
+        parse_field(current, tokens[t]);
+      }
+    } else if (strcmp(tokens[0], "archetype") == 0 && count >= 2) {
+      int a = archetype_id(tokens[1]);
+      if (a < 0) {
+        fail("unknown archetype", tokens[1]);
+      }
+      if (defined[a]) {
+        fail("archetype defined twice", tokens[1]);
+      }
+      defined[a] = true;
+      current = &data->archetypes[a];
+      for (int t = 2; t < count; t++) {
+        parse_field(current, tokens[t]);
+      }
+    } else if (strcmp(tokens[0], "single") == 0 && count == 1) {
+      if (data->waves.singleCount == MAX_PATTERNS) {
+        fail("too many single-line waves", NULL);
+      }
+      wave = &data->waves.single[data->waves.singleCount++];
+      current = NULL;
+      rowsLeft = 1;
+      row = 0;
+    } else if (strcmp(tokens[0], "multi") == 0 && count == 1) {
+      if (data->waves.multiCount == MAX_PATTERNS) {
+        fail("too many multi-line waves", NULL);
+      }
+      wave = &data->waves.multi[data->waves.multiCount++];
+      current = NULL;
+      rowsLeft = PATTERN_ROWS;
+      row = 0;
+    } else {
+      fail("expected archetype, single or multi", tokens[0]);
+    }
+  }
+  if (rowsLeft > 0) {
+    fail("last wave is missing rows", NULL);
+  }
+  for (int a = 0; a < ARCHETYPE_COUNT; a++) {
+    if (!defined[a]) {
+      fail("archetype not defined", archetypeNames[a]);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  bool checkOnly = argc == 3 && strcmp(argv[1], "--check") == 0;
+  if (!checkOnly && argc != 3) {
+    fprintf(stderr, "usage: %s SOURCE OUT | --check SOURCE\n", argv[0]);
+    return 1;
+  }
+  sourcePath = checkOnly ? argv[2] : argv[1];
+  FILE *file = fopen(sourcePath, "r");
+  if (file == NULL) {
+    fprintf(stderr, "gameDataBuild: cannot read %s\n", sourcePath);
+    return 1;
+  }
+  static GameData data;
+  parse_source(file, &data);
+  fclose(file);
+
+  char error[256];
+  if (!gamedata_check(&data, error, sizeof(error))) {
+    fprintf(stderr, "%s: %s\n", sourcePath, error);
+    return 1;
+  }
+  if (checkOnly) {
+    printf("%s: %d archetypes, %d single-line and %d multi-line waves\n",
+           sourcePath, ARCHETYPE_COUNT, data.waves.singleCount,
+           data.waves.multiCount);
+    return 0;
+  }
+
+  size_t size = gamedata_size(&data);
+  unsigned char *table = malloc(size);
+  gamedata_encode(&data, table);
+  FILE *out = fopen(argv[2], "wb");
+  bool ok = out != NULL && fwrite(table, 1, size, out) == size;
+  if (out != NULL) {
+    ok = fclose(out) == 0 && ok;
+  }
+  free(table);
+  if (!ok) {
+    fprintf(stderr, "gameDataBuild: cannot write %s\n", argv[2]);
+    remove(argv[2]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include "latency.h"
+#include <string.h>
+
+#define LATENCY_BAR_WIDTH 50
+
+void latency_init(LatencyMeter *meter) {
+  memset(meter, 0, sizeof(LatencyMeter));
+}
+
+void latency_input(LatencyMeter *meter, uint64_t polledNs) {
+  if (meter->polledNs == 0) {
+    meter->polledNs = polledNs;
+  }
+}
+
+void latency_consumed(LatencyMeter *meter) {
+  if (meter->polledNs != 0 && meter->consumedNs == 0) {
+    meter->consumedNs = meter->polledNs;
+    meter->polledNs = 0;
+  }
+}
+
+void latency_presented(LatencyMeter *meter, uint64_t swappedNs) {
+  if (meter->consumedNs == 0) {
+    return;
+  }
+  uint64_t latency = swappedNs - meter->consumedNs;
+  meter->consumedNs = 0;
+  int bucket = (int)(latency / 1000000);
+  meter->histogram[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+  if (meter->samples == 0 || latency < meter->minNs) {
+    meter->minNs = latency;
+  }
+  if (latency > meter->maxNs) {
+    meter->maxNs = latency;
+  }
+  meter->samples++;
+  meter->totalNs += latency;
+}
+
+int latency_percentile(const LatencyMeter *meter, int percent) {
+  unsigned long target = (meter->samples * percent + 99) / 100;
+  unsigned long seen = 0;
+  for (int b = 0; b < LATENCY_BUCKETS; b++) {
+    seen += meter->histogram[b];
+    if (seen >= target && seen > 0) {
+      return b + 1;
+    }
+  }
+  return 0;
+}
+
+void latency_report(const LatencyMeter *meter, FILE *out) {
+  fprintf(out, "input-to-photon latency, %lu key presses\n", meter->samples);
+  if (meter->samples == 0) {
+    return;
+  }
+  fprintf(out, "min %.1f  mean %.1f  max %.1f ms  p50 <%d  p95 <%d  p99 <%d\n",
+          meter->minNs / 1e6, meter->totalNs / 1e6 / meter->samples,
+          meter->maxNs / 1e6, latency_percentile(meter, 50),
+          latency_percentile(meter, 95), latency_percentile(meter, 99));
+  unsigned int most = 0;
+  int first = LATENCY_BUCKETS, last = 0;
+  for (int b = 0; b < LATENCY_BUCKETS; b++) {
+    if (meter->histogram[b] > 0) {
+      first = b < first ? b : first;
+      last = b;
+    }
+    most = meter->histogram[b] > most ? meter->histogram[b] : most;
+  }
+  for (int b = first; b <= last; b++) {
+    char bar[LATENCY_BAR_WIDTH + 1];
+    int width = (int)(meter->histogram[b] * LATENCY_BAR_WIDTH / most);
+    memset(bar, '#', width);
+    bar[width] = '\0';
+    if (b == LATENCY_BUCKETS - 1) {
+      fprintf(out, "   >=%2d ms %6u %s\n", b, meter->histogram[b], bar);
+    } else {
+      fprintf(out, "%3d-%2d ms %6u %s\n", b, b + 1, meter->histogram[b], bar);
+    }
+  }
+}
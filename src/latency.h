@@ -0,0 +1,43 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+// Input-to-photon latency. The front end reports three moments: when the
+// input poll that saw a key go down returned, when a simulation tick used
+// that input, and when the swap of the frame drawn from that tick returned.
+// Each key press that makes it to the screen adds one sample, the time from
+// the poll to the swap. A press is timed from the earliest poll that saw it,
+// so presses waiting on a frame with no tick to run count the wait too.
+//
+// Needs the game loop to own the swap and the poll (GAME_FRAME_CONTROL);
+// inside raylib's EndDrawing there is nowhere to take the timestamps.
+
+#include <stdint.h>
+#include <stdio.h>
+
+// One bucket per millisecond, the last one holds everything longer
+#define LATENCY_BUCKETS 100
+
+typedef struct {
+  // key down seen by a poll and not yet used by a tick, 0 if none
+  uint64_t polledNs;
+  // key down used by the tick the frame being drawn shows, 0 if none
+  uint64_t consumedNs;
+  unsigned int histogram[LATENCY_BUCKETS];
+  unsigned long samples;
+  uint64_t totalNs;
+  uint64_t minNs;
+  uint64_t maxNs;
+} LatencyMeter;
+
+void latency_init(LatencyMeter *meter);
+// A poll that returned at polledNs saw a key go down
+void latency_input(LatencyMeter *meter, uint64_t polledNs);
+// A tick has used the input polled so far
+void latency_consumed(LatencyMeter *meter);
+// The swap of the frame drawn since the last call returned at swappedNs
+void latency_presented(LatencyMeter *meter, uint64_t swappedNs);
+// Upper edge, in milliseconds, of the bucket holding the given percentile
+int latency_percentile(const LatencyMeter *meter, int percent);
+void latency_report(const LatencyMeter *meter, FILE *out);
+
+#endif
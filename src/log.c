@@ -0,0 +1,174 @@
+#include "log.h"
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+// Bounded multi-producer queue: a slot is free for the producer that claims
+// position pos when its sequence is pos, and ready for the writer when it is
+// pos + 1. The writer hands it back by adding the ring size.
+typedef struct {
+  _Atomic unsigned int sequence;
+  GameLogLevel level;
+  char text[LOG_MESSAGE_SIZE];
+} LogSlot;
+
+GameLogLevel gameLogLevel = GAME_LOG_DEBUG;
+
+static LogSlot slots[LOG_RING_SIZE];
+static _Atomic unsigned int enqueuePos;
+static unsigned int dequeuePos;
+static _Atomic unsigned int dropped;
+static _Atomic bool running = false;
+// producers between checking running and posting their message; log_stop
+// waits for them before it takes the semaphore away
+static _Atomic unsigned int producers;
+static sem_t pending;
+static pthread_t writer;
+
+static FILE *log_stream(GameLogLevel level) {
+  return level >= GAME_LOG_WARNING ? stderr : stdout;
+}
+
+static int log_format(char *out, const char *prefix, const char *format,
+                      va_list args) {
+  int used = 0;
+  if (prefix != NULL) {
+    used = snprintf(out, LOG_MESSAGE_SIZE, "%s", prefix);
+  }
+  int n = vsnprintf(out + used, LOG_MESSAGE_SIZE - used, format, args);
+  used = n < 0 ? used : used + n;
+  return used < LOG_MESSAGE_SIZE ? used : LOG_MESSAGE_SIZE - 1;
+}
+
+static void log_push(GameLogLevel level, const char *prefix,
+                     const char *format, va_list args, bool newline) {
+  // sequentially consistent with log_stop's store to running and load of
+  // producers: either this sees it stopping, or log_stop sees this producer
+  atomic_fetch_add(&producers, 1);
+  if (!atomic_load(&running)) {
+    atomic_fetch_sub(&producers, 1);
+    char text[LOG_MESSAGE_SIZE + 1];
+    int n = log_format(text, prefix, format, args);
+    if (newline && (n == 0 || text[n - 1] != '\n')) {
+      text[n++] = '\n';
+      text[n] = '\0';
+    }
+    fputs(text, log_stream(level));
+    return;
+  }
+
+  unsigned int pos = atomic_load_explicit(&enqueuePos, memory_order_relaxed);
+  LogSlot *slot;
+  for (;;) {
+    slot = &slots[pos % LOG_RING_SIZE];
+    unsigned int sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    int diff = (int)(sequence - pos);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&enqueuePos, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // the writer is a whole ring behind
+      atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+      atomic_fetch_sub(&producers, 1);
+      return;
+    } else {
+      pos = atomic_load_explicit(&enqueuePos, memory_order_relaxed);
+    }
+  }
+  slot->level = level;
+  int n = log_format(slot->text, prefix, format, args);
+  if (newline && (n == 0 || slot->text[n - 1] != '\n')) {
+    // a message cut at the slot size loses its last character instead
+    n = n < LOG_MESSAGE_SIZE - 1 ? n : LOG_MESSAGE_SIZE - 2;
+    slot->text[n++] = '\n';
+    slot->text[n] = '\0';
+  }
+  atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+  sem_post(&pending);
+  atomic_fetch_sub(&producers, 1);
+}
+
+void game_log_write(GameLogLevel level, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  log_push(level, NULL, format, args, false);
+  va_end(args);
+}
+
+void game_log_vwrite(GameLogLevel level, const char *prefix,
+                     const char *format, va_list args) {
+  if (level >= GAME_LOG_MIN_LEVEL && level >= gameLogLevel) {
+    log_push(level, prefix, format, args, true);
+  }
+}
+
+// Write every message that is ready. Only the writer thread, or log_stop
+// once it has joined it, calls this.
+static void log_drain(void) {
+  for (;;) {
+    LogSlot *slot = &slots[dequeuePos % LOG_RING_SIZE];
+    unsigned int sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != dequeuePos + 1) {
+      break;
+    }
+    fputs(slot->text, log_stream(slot->level));
+    atomic_store_explicit(&slot->sequence, dequeuePos + LOG_RING_SIZE,
+                          memory_order_release);
+    dequeuePos++;
+  }
+  unsigned int lost = atomic_exchange(&dropped, 0);
+  if (lost > 0) {
+    fprintf(stderr, "LOG: %u messages dropped\n", lost);
+  }
+}
+
+static void *log_writer(void *arg) {
+  (void)arg;
+  while (atomic_load_explicit(&running, memory_order_acquire)) {
+    sem_wait(&pending);
+    log_drain();
+  }
+  return NULL;
+}
+
+void log_start(void) {
+  if (atomic_load(&running)) {
+    return;
+  }
+  for (unsigned int i = 0; i < LOG_RING_SIZE; i++) {
+    atomic_store(&slots[i].sequence, i);
+  }
+  atomic_store(&enqueuePos, 0);
+  dequeuePos = 0;
+  sem_init(&pending, 0, 0);
+  atomic_store(&running, true);
+  pthread_create(&writer, NULL, log_writer, NULL);
+}
+
+void log_stop(void) {
+  if (!atomic_load(&running)) {
+    return;
+  }
+  atomic_store(&running, false);
+  // producers that saw running just before it changed may still be filling
+  // their slots; once they are done every claimed slot is published, and
+  // later calls go direct
+  while (atomic_load(&producers) > 0) {
+    sched_yield();
+  }
+  sem_post(&pending);
+  pthread_join(writer, NULL);
+  log_drain();
+  sem_destroy(&pending);
+  fflush(stdout);
+  fflush(stderr);
+}
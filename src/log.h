@@ -0,0 +1,48 @@
+#ifndef LOG_H
+#define LOG_H
+
+// Logging that stays off the frame. game_log formats the message straight
+// into a slot of a lock-free ring and returns; a background thread started by
+// log_start writes the slots out. Before log_start, or after log_stop, the
+// message is written synchronously instead.
+//
+// Calls below GAME_LOG_MIN_LEVEL are removed at compile time, arguments and
+// all. gameLogLevel filters the rest at run time.
+
+#include <stdarg.h>
+
+typedef enum {
+  GAME_LOG_DEBUG = 0,
+  GAME_LOG_INFO,
+  GAME_LOG_WARNING,
+  GAME_LOG_NONE
+} GameLogLevel;
+
+#ifndef GAME_LOG_MIN_LEVEL
+#define GAME_LOG_MIN_LEVEL GAME_LOG_DEBUG
+#endif
+
+// Longest message kept, longer ones are cut
+#define LOG_MESSAGE_SIZE 256
+// Messages that can wait for the writer; more than that are dropped
+#define LOG_RING_SIZE 1024
+
+extern GameLogLevel gameLogLevel;
+
+#define game_log(level, ...)                                                   \
+  do {                                                                         \
+    if ((level) >= GAME_LOG_MIN_LEVEL && (level) >= gameLogLevel) {            \
+      game_log_write(level, __VA_ARGS__);                                      \
+    }                                                                          \
+  } while (0)
+
+void game_log_write(GameLogLevel level, const char *format, ...);
+// prefix goes before the message and a missing newline is added, for
+// messages from other libraries' log hooks
+void game_log_vwrite(GameLogLevel level, const char *prefix,
+                     const char *format, va_list args);
+void log_start(void);
+// Write out what is queued and stop the writer thread
+void log_stop(void);
+
+#endif
@@ -0,0 +1,165 @@
+// Private copy, raylib's own is not part of its public API. Its functions
+// cannot be made static, so they are renamed to stay clear of the copy
+// raudio.c links in, and it comes ahead of music.h, which would otherwise
+// pull in the header part under the original names.
+#define qoa_encode_header music_qoa_encode_header
+#define qoa_encode_frame music_qoa_encode_frame
+#define qoa_encode music_qoa_encode
+#define qoa_max_frame_size music_qoa_max_frame_size
+#define qoa_decode_header music_qoa_decode_header
+#define qoa_decode_frame music_qoa_decode_frame
+#define qoa_decode music_qoa_decode
+#define QOA_NO_STDIO
+#define QOA_IMPLEMENTATION
+#include "external/qoa.h"
+// only the header part is guarded
+#undef QOA_IMPLEMENTATION
+
+#include "music.h"
+#include "assets.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  GameMusic *music;
+  const AssetPack *pack;
+} MusicLoad;
+
+static MusicLoad load;
+
+// Read the QOA header and fault the file in, and allocate the buffers the
+// decoding needs; the source file is left to raylib
+static bool music_decode(void *user) {
+  MusicLoad *load = user;
+  GameMusic *music = load->music;
+  const AssetEntry *entry =
+      asset_pack_find(load->pack, soundNames[SOUND_MUSIC], ASSET_MUSIC_QOA);
+  music->fromPack = entry != NULL;
+  if (!music->fromPack) {
+    return true;
+  }
+  asset_pack_prefetch(load->pack, entry);
+  music->data = asset_pack_data(load->pack, entry);
+  music->size = entry->size;
+  music->firstFrame =
+      qoa_decode_header(music->data, (int)music->size, &music->qoa);
+  unsigned int channels = music->qoa.channels;
+  if (music->firstFrame == 0 || channels == 0 ||
+      channels > QOA_MAX_CHANNELS) {
+    return false;
+  }
+  music->next = music->firstFrame;
+  music->frame = malloc(QOA_FRAME_LEN * channels * sizeof(short));
+  music->chunk = malloc(MUSIC_STREAM_FRAMES * channels * sizeof(short));
+  return music->frame != NULL && music->chunk != NULL;
+}
+
+static bool music_upload(void *user, bool decoded) {
+  MusicLoad *load = user;
+  GameMusic *music = load->music;
+  if (!decoded) {
+    return false;
+  }
+  if (music->fromPack) {
+    SetAudioStreamBufferSizeDefault(MUSIC_STREAM_FRAMES);
+    music->stream =
+        LoadAudioStream(music->qoa.samplerate, 16, music->qoa.channels);
+    SetAudioStreamBufferSizeDefault(0);
+    music->loaded = IsAudioStreamValid(music->stream);
+  } else {
+    char path[ASSET_PATH_MAX];
+    music->file = LoadMusicStream(asset_source_path(
+        path, sizeof(path), ASSET_SOURCE_DIR, soundFiles[SOUND_MUSIC]));
+    music->loaded = IsMusicValid(music->file);
+  }
+  return music->loaded;
+}
+
+AssetHandle music_queue(GameMusic *music, AssetLoader *loader,
+                        const AssetPack *pack) {
+  memset(music, 0, sizeof(GameMusic));
+  load = (MusicLoad){.music = music, .pack = pack};
+  return asset_loader_add(loader, soundNames[SOUND_MUSIC], music_decode,
+                          music_upload, &load);
+}
+
+// Decode the next frame, going back to the first after the last. A frame
+// that does not decode ends the file early.
+static bool music_next_frame(GameMusic *music) {
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (music->next >= music->size) {
+      music->next = music->firstFrame;
+    }
+    unsigned int used = qoa_decode_frame(
+        music->data + music->next, music->size - music->next, &music->qoa,
+        music->frame, &music->frameLength);
+    if (used > 0 && music->frameLength > 0) {
+      music->next += used;
+      music->framePosition = 0;
+      return true;
+    }
+    music->next = music->size;
+  }
+  return false;
+}
+
+void music_update(GameMusic *music) {
+  if (!music->loaded) {
+    return;
+  }
+  if (!music->fromPack) {
+    UpdateMusicStream(music->file);
+    return;
+  }
+  unsigned int channels = music->qoa.channels;
+  while (IsAudioStreamProcessed(music->stream)) {
+    unsigned int filled = 0;
+    while (filled < MUSIC_STREAM_FRAMES) {
+      if (music->framePosition == music->frameLength &&
+          !music_next_frame(music)) {
+        break;
+      }
+      unsigned int n = music->frameLength - music->framePosition;
+      if (n > MUSIC_STREAM_FRAMES - filled) {
+        n = MUSIC_STREAM_FRAMES - filled;
+      }
+      memcpy(music->chunk + filled * channels,
+             music->frame + music->framePosition * channels,
+             n * channels * sizeof(short));
+      filled += n;
+      music->framePosition += n;
+    }
+    // raylib pads a short chunk with silence
+    UpdateAudioStream(music->stream, music->chunk, (int)filled);
+  }
+}
+
+void music_play(GameMusic *music, float volume) {
+  if (!music->loaded) {
+    return;
+  }
+  if (music->fromPack) {
+    // fill both halves before the mixer starts pulling
+    music_update(music);
+    SetAudioStreamVolume(music->stream, volume);
+    PlayAudioStream(music->stream);
+  } else {
+    SetMusicVolume(music->file, volume);
+    PlayMusicStream(music->file);
+  }
+}
+
+void music_free(GameMusic *music) {
+  if (music->loaded) {
+    if (music->fromPack) {
+      UnloadAudioStream(music->stream);
+    } else {
+      UnloadMusicStream(music->file);
+    }
+    music->loaded = false;
+  }
+  free(music->frame);
+  free(music->chunk);
+  music->frame = NULL;
+  music->chunk = NULL;
+}
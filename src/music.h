@@ -0,0 +1,49 @@
+#ifndef MUSIC_H
+#define MUSIC_H
+
+// Background music. The asset pack's QOA is decoded a frame at a time
+// straight out of the pack's mapping into an AudioStream the game fills
+// itself, so loading it copies nothing: the loader thread reads the header
+// and faults the file in, and the main thread only creates the stream.
+// Without a pack, raylib streams the source file as it plays.
+
+#include "assetloader.h"
+#include "assetpack.h"
+#include "external/qoa.h"
+#include "raylib.h"
+
+// Frames per half of the stream's double buffer, about 0.19 s at 44.1 kHz.
+// raylib rounds it up to the device period, which must not be larger.
+#define MUSIC_STREAM_FRAMES 8192
+
+typedef struct {
+  bool fromPack;
+  bool loaded;
+  // the pack's QOA
+  const unsigned char *data;
+  unsigned int size;
+  qoa_desc qoa;
+  // byte offsets of the first frame and of the next one to decode
+  unsigned int firstFrame;
+  unsigned int next;
+  // the frame decoded last and how much of it has been streamed
+  short *frame;
+  unsigned int frameLength;
+  unsigned int framePosition;
+  // one half of the stream's buffer, filled from frame
+  short *chunk;
+  AudioStream stream;
+  // the source file
+  Music file;
+} GameMusic;
+
+// Queue the music on the loader, from the pack if it has it
+AssetHandle music_queue(GameMusic *music, AssetLoader *loader,
+                        const AssetPack *pack);
+// Start a loaded track, looping
+void music_play(GameMusic *music, float volume);
+// Refill whatever the mixer has used up, once a frame
+void music_update(GameMusic *music);
+void music_free(GameMusic *music);
+
+#endif
@@ -0,0 +1,46 @@
+#include "pacing.h"
+#include <string.h>
+
+void pacer_init(FramePacer *pacer, uint64_t frameNs) {
+  memset(pacer, 0, sizeof(FramePacer));
+  pacer->frameNs = frameNs;
+}
+
+// The slowest recent frame rather than an average: a prediction that comes
+// in short costs a late swap, one that comes in long only costs latency
+uint64_t pacer_predict(const FramePacer *pacer) {
+  uint64_t slowest = 0;
+  for (int i = 0; i < pacer->filled; i++) {
+    if (pacer->work[i] > slowest) {
+      slowest = pacer->work[i];
+    }
+  }
+  // with no history yet, start the work as early as the frame allows
+  if (pacer->filled == 0) {
+    return pacer->frameNs;
+  }
+  return slowest + PACING_MARGIN_NS;
+}
+
+uint64_t pacer_wake(FramePacer *pacer, uint64_t nowNs) {
+  uint64_t predicted = pacer_predict(pacer);
+  pacer->deadlineNs += pacer->frameNs;
+  // behind by a frame or more, from a slow frame or a stall: start now and
+  // count the frames from here
+  if (pacer->deadlineNs < nowNs + predicted) {
+    pacer->deadlineNs = nowNs + predicted;
+  }
+  return pacer->deadlineNs - predicted;
+}
+
+void pacer_work_start(FramePacer *pacer, uint64_t nowNs) {
+  pacer->workStartNs = nowNs;
+}
+
+void pacer_work_end(FramePacer *pacer, uint64_t nowNs) {
+  pacer->work[pacer->head] = nowNs - pacer->workStartNs;
+  pacer->head = (pacer->head + 1) % PACING_HISTORY;
+  if (pacer->filled < PACING_HISTORY) {
+    pacer->filled++;
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef PACING_H
+#define PACING_H
+
+// Late-latched frame pacing. Instead of doing a frame's work straight after
+// the last swap and then waiting out the rest of the frame, the loop waits
+// first and starts the work, input poll included, only as late as it can
+// while still swapping on time. How late that is comes from how long the
+// work took over the last few frames, so input is read close to when its
+// frame is shown and a frame that turns out slow still makes its swap.
+
+#include <stdint.h>
+
+// Frames of work time the prediction looks at
+#define PACING_HISTORY 32
+// Added to the prediction for what the history has not seen yet
+#define PACING_MARGIN_NS 1000000
+
+typedef struct {
+  uint64_t frameNs;
+  // when the next swap is due
+  uint64_t deadlineNs;
+  uint64_t workStartNs;
+  uint64_t work[PACING_HISTORY];
+  int head;
+  int filled;
+} FramePacer;
+
+void pacer_init(FramePacer *pacer, uint64_t frameNs);
+// Time the next frame's work should start at, given the time now; the
+// frame's swap deadline moves on by one frame with each call
+uint64_t pacer_wake(FramePacer *pacer, uint64_t nowNs);
+// Bracket the work of a frame, from the input poll to just before the swap
+void pacer_work_start(FramePacer *pacer, uint64_t nowNs);
+void pacer_work_end(FramePacer *pacer, uint64_t nowNs);
+// Work time expected for the next frame, margin included
+uint64_t pacer_predict(const FramePacer *pacer);
+
+#endif
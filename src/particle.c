@@ -0,0 +1,179 @@
+#include "game.h"
+#include <stdlib.h>
+
+// Filled from the game data table by game_init
+Archetype archetypes[ARCHETYPE_COUNT];
+
+void particle_system_init(ParticleSystem *system, int capacity, int speed) {
+  system->x = malloc(capacity * sizeof(int));
+  system->y = malloc(capacity * sizeof(int));
+  system->dy = malloc(capacity * sizeof(int));
+  system->health = malloc(capacity * sizeof(int));
+  system->type = malloc(capacity * sizeof(ParticleType));
+  system->phase = malloc(capacity * sizeof(unsigned long));
+  system->archetype = malloc(capacity * sizeof(unsigned char));
+  system->isAlive = malloc(capacity * sizeof(bool));
+  system->alive = malloc(capacity * sizeof(int));
+  system->freeSlots = malloc(capacity * sizeof(int));
+  system->capacity = capacity;
+  system->speed = speed;
+  particle_system_reset(system);
+}
+
+// Kill every particle and put all slots back on the free list
+void particle_system_reset(ParticleSystem *system) {
+  system->count = 0;
+  system->freeCount = 0;
+  // push in reverse so the lowest slots are handed out first
+  for (int i = system->capacity - 1; i >= 0; i--) {
+    system->isAlive[i] = false;
+    system->freeSlots[system->freeCount++] = i;
+  }
+}
+
+// Take a slot off the free list and append it to the alive list. Returns -1
+// when every slot is in use; the caller decides whether to drop the spawn.
+int particle_system_acquire(ParticleSystem *system) {
+  if (system->freeCount == 0) {
+    return -1;
+  }
+  int index = system->freeSlots[--system->freeCount];
+  system->alive[system->count++] = index;
+  return index;
+}
+
+// Acquire a slot and initialise its hot fields from the archetype. Returns
+// the slot, or -1 when the pool is full. tick is the current simulation tick,
+// which becomes the particle's animation phase.
+int particle_system_spawn(ParticleSystem *system, int archetype, int x, int y,
+                          unsigned long tick) {
+  int i = particle_system_acquire(system);
+  if (i < 0) {
+    return -1;
+  }
+  const Archetype *a = &archetypes[archetype];
+  system->x[i] = x;
+  system->y[i] = y;
+  system->dy[i] = a->dy;
+  system->health[i] = a->health;
+  system->type[i] = a->type;
+  system->phase[i] = tick;
+  system->archetype[i] = archetype;
+  system->isAlive[i] = true;
+  return i;
+}
+
+// Drop the slots that died since the last sweep from the alive list and hand
+// them back to the free list. Every pass that can kill a particle sweeps
+// before returning, so the other passes only ever see live slots.
+void particle_system_sweep(ParticleSystem *system) {
+  int n = 0;
+  for (int k = 0; k < system->count; k++) {
+    int i = system->alive[k];
+    if (system->isAlive[i]) {
+      system->alive[n++] = i;
+    } else {
+      system->freeSlots[system->freeCount++] = i;
+    }
+  }
+  system->count = n;
+}
+
+void particle_spawn_projectiles(GameSession *session) {
+  if (session->tick % (int)(session->projectileInterval * TICK_RATE) == 0) {
+    const Archetype *s = &archetypes[ARCHETYPE_SHARK];
+    const Archetype *h = &archetypes[ARCHETYPE_HARPOON];
+    int index = particle_system_spawn(
+        &session->projectiles, ARCHETYPE_HARPOON,
+        session->shark.x + (s->frameWidth / 2 - h->frameWidth / 2),
+        session->shark.y - h->frameHeight, session->tick);
+    if (index < 0) {
+      game_log(GAME_LOG_WARNING, "PARTICLE: Projectile pool exhausted\n");
+    } else {
+      session->events[GAME_EVENT_FIRE]++;
+    }
+  }
+}
+
+void particle_system_free(ParticleSystem *system) {
+  free(system->x);
+  free(system->y);
+  free(system->dy);
+  free(system->health);
+  free(system->type);
+  free(system->phase);
+  free(system->archetype);
+  free(system->isAlive);
+  free(system->alive);
+  free(system->freeSlots);
+}
+
+void particle_update_system(ParticleSystem *system) {
+  for (int k = 0; k < system->count; k++) {
+    int i = system->alive[k];
+    const Archetype *a = &archetypes[system->archetype[i]];
+    if (system->health[i] <= 0 &&
+        (system->type[i] < 1 || system->type[i] > 48)) {
+      system->isAlive[i] = false;
+    }
+
+    if (system->y[i] > SCREEN_HEIGHT + a->h) {
+      system->isAlive[i] = false;
+    } else if (system->type[i] == PROJECTILE &&
+               system->y[i] + a->frameHeight < 0) {
+      system->isAlive[i] = false;
+    } else {
+      system->y[i] += system->dy[i];
+      if ((system->type[i] & BOX) == BOX && system->health[i] <= 0) {
+        // A broken box releases the powerup inside
+        game_log(GAME_LOG_DEBUG, "PARTICLE: Box converted to power up\n");
+        system->type[i] ^= BOX;
+      }
+    }
+  }
+  particle_system_sweep(system);
+}
+
+int particle_enemy_system_create_particle(ParticleSystem *system,
+                                          int particleType, int x,
+                                          unsigned long tick) {
+  int archetype = ARCHETYPE_STRAW + particleType;
+  int i = particle_system_spawn(system, archetype, x,
+                                -archetypes[archetype].frameHeight, tick);
+  if (i < 0) {
+    game_log(GAME_LOG_WARNING, "PARTICLE: Enemy pool exhausted\n");
+  }
+  return i;
+}
+
+int particle_power_system_create_particle(ParticleSystem *system,
+                                          int particleType, int x,
+                                          unsigned long tick) {
+  int archetype = ARCHETYPE_CRATE + particleType;
+  int i = particle_system_spawn(system, archetype, x,
+                                -archetypes[archetype].frameHeight, tick);
+  if (i < 0) {
+    game_log(GAME_LOG_WARNING, "PARTICLE: Powerup pool exhausted\n");
+  }
+  return i;
+}
+
+int particle_boss_system_create_particle(ParticleSystem *system,
+                                         int particleType, int x,
+                                         unsigned long tick) {
+  int archetype = ARCHETYPE_ORCA + particleType;
+  int i = particle_system_spawn(system, archetype, x,
+                                -archetypes[archetype].frameHeight, tick);
+  if (i < 0) {
+    game_log(GAME_LOG_WARNING, "PARTICLE: Boss pool exhausted\n");
+  }
+  return i;
+}
+
+// Animation frame of an archetype's sprite at tick for something whose
+// animation started at phase. Nothing is stored per frame, so an animation
+// costs nothing until it is drawn.
+unsigned int archetype_frame(const Archetype *a, unsigned long tick,
+                             unsigned long phase) {
+  return (unsigned int)((tick - phase) / a->frameTicks) % a->numberOfFrames;
+}
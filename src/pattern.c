@@ -0,0 +1,91 @@
+#include "game.h"
+
+// Filled from the game data table by game_init
+WaveTable waves;
+
+// Spawn one row of a wave, cell c at screen column PATTERN_FIRST_COLUMN + c
+static void spawn_row(GameSession *session, const unsigned char *cells) {
+  for (int c = 0; c < PATTERN_COLUMNS; c++) {
+    int x = (PATTERN_FIRST_COLUMN + c) * 32;
+    switch (cells[c]) {
+    case PATTERN_GAP:
+      break;
+    case PATTERN_ENEMY: {
+      int e = game_random(session, 0, 4);
+      particle_enemy_system_create_particle(&session->enemies, e, x,
+                                            session->tick);
+      break;
+    }
+    case PATTERN_POWERUP: {
+      game_log(GAME_LOG_DEBUG, "SPAWNING POWER\n");
+      int f = game_random(session, 1, 5);
+      particle_power_system_create_particle(&session->powerups, f, x,
+                                            session->tick);
+      break;
+    }
+    default: {
+      int archetype = cells[c] - PATTERN_ARCHETYPE;
+      if (particle_system_spawn(&session->bosses, archetype, x,
+                                -archetypes[archetype].frameHeight,
+                                session->tick) < 0) {
+        game_log(GAME_LOG_WARNING, "PARTICLE: Boss pool exhausted\n");
+      }
+      break;
+    }
+    }
+  }
+}
+
+void particle_queue_pattern(GameSession *session) {
+  unsigned long frameCount = session->tick;
+  ParticleSystem *powerup = &session->powerups;
+  ParticleSystem *enemy = &session->enemies;
+  ParticleSystem *boss = &session->bosses;
+  if (frameCount < session->nextPatternTime) {
+    return;
+  }
+  // Can I generate a pattern at this time?
+  ParticleSystem *systems[3] = {powerup, enemy, boss};
+  for (int s = 0; s < 3; s++) {
+    for (int k = 0; k < systems[s]->count; k++) {
+      if (systems[s]->y[systems[s]->alive[k]] < 0) {
+        return;
+      }
+    }
+  }
+  // Do I delay generation?
+  if (session->lastInterval == interval(session, frameCount, 60)) {
+    int r = game_random(session, 0, waves.singleCount - 1);
+    spawn_row(session, waves.single[r].cells[0]);
+  } else {
+    int r = game_random(session, 0, waves.multiCount - 1);
+    for (int j = 0; j < PATTERN_ROWS; j++) {
+      spawn_row(session, waves.multi[r].cells[j]);
+    }
+  }
+  // Do I generate a single line or multiple pattern
+  // Which patterd do I choose:
+
+  session->lastInterval = interval(session, frameCount, 60);
+  session->nextPatternTime = frameCount + session->lastInterval * 60;
+}
+
+int interval(GameSession *session, unsigned long frameCount, const int fps) {
+  int time = frameCount / fps;
+  if (time < 30) {
+    session->score++;
+    return 6;
+  } else if (time < 75) {
+    session->score += 2;
+    return 4;
+  } else if (time < 150) {
+    session->score += 3;
+    return 2;
+  } else if (time < 240) {
+    session->score += 4;
+    return 1;
+  } else {
+    session->score += 5;
+    return 0;
+  }
+}
@@ -0,0 +1,79 @@
+#include "profile.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool profileEnabled = false;
+
+static const char *zoneNames[PROFILE_ZONE_COUNT] = {
+    [PROFILE_SIMULATION] = "simulation", [PROFILE_PATTERN] = "pattern",
+    [PROFILE_UPDATE] = "update",        [PROFILE_COLLISION] = "collision",
+    [PROFILE_MUSIC] = "music",           [PROFILE_ASSETS] = "asset upload",
+    [PROFILE_DRAW] = "draw",             [PROFILE_BATCH] = "batch flush",
+    [PROFILE_PRESENT] = "present+wait",
+};
+
+static uint64_t current[PROFILE_ZONE_COUNT];
+static uint64_t zones[PROFILE_HISTORY][PROFILE_ZONE_COUNT];
+static uint64_t frames[PROFILE_HISTORY];
+// scratch for sorting, so percentiles never allocate
+static uint64_t sorted[PROFILE_HISTORY];
+static int head = 0;
+static int filled = 0;
+
+void profile_record(ProfileZone zone, uint64_t start, uint64_t end) {
+  // a zone that began before profiling was switched on has no start time
+  if (start == 0) {
+    return;
+  }
+  if (profileEnabled) {
+    current[zone] += end - start;
+  }
+  trace_complete(zoneNames[zone], start, end);
+}
+
+void profile_frame_end(uint64_t frameNs) {
+  if (!profileEnabled) {
+    return;
+  }
+  memcpy(zones[head], current, sizeof(current));
+  memset(current, 0, sizeof(current));
+  frames[head] = frameNs;
+  head = (head + 1) % PROFILE_HISTORY;
+  if (filled < PROFILE_HISTORY) {
+    filled++;
+  }
+}
+
+const char *profile_zone_name(ProfileZone zone) { return zoneNames[zone]; }
+
+uint64_t profile_zone_ns(ProfileZone zone) {
+  if (filled == 0) {
+    return 0;
+  }
+  return zones[(head + PROFILE_HISTORY - 1) % PROFILE_HISTORY][zone];
+}
+
+static int compare_ns(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+void profile_percentiles(uint64_t *p50, uint64_t *p95, uint64_t *p99) {
+  if (filled == 0) {
+    *p50 = *p95 = *p99 = 0;
+    return;
+  }
+  memcpy(sorted, frames, filled * sizeof(uint64_t));
+  qsort(sorted, filled, sizeof(uint64_t), compare_ns);
+  *p50 = sorted[(filled - 1) * 50 / 100];
+  *p95 = sorted[(filled - 1) * 95 / 100];
+  *p99 = sorted[(filled - 1) * 99 / 100];
+}
+
+void profile_reset(void) {
+  memset(current, 0, sizeof(current));
+  head = 0;
+  filled = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Frame profiler. Zones add their elapsed nanoseconds to the current frame,
+// profile_frame_end moves the totals into a fixed ring of past frames. While
+// a trace is being recorded (trace.h) every zone is also a trace event. With
+// both off every zone costs one predictable branch; headless tools never turn
+// either on, so sessions on other threads never touch them.
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// Frames kept for the percentile stats, about ten seconds at 60 fps
+#define PROFILE_HISTORY 600
+
+typedef enum {
+  PROFILE_SIMULATION = 0,
+  PROFILE_PATTERN,
+  PROFILE_UPDATE,
+  PROFILE_COLLISION,
+  PROFILE_MUSIC,
+  PROFILE_ASSETS,
+  PROFILE_DRAW,
+  PROFILE_BATCH,
+  PROFILE_PRESENT,
+  PROFILE_ZONE_COUNT
+} ProfileZone;
+
+extern bool profileEnabled;
+// set by trace_open in trace.c, read from every thread that records
+extern _Atomic bool traceEnabled;
+
+static inline bool trace_enabled(void) {
+  return atomic_load_explicit(&traceEnabled, memory_order_relaxed);
+}
+
+static inline uint64_t profile_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void profile_record(ProfileZone zone, uint64_t start, uint64_t end);
+
+static inline uint64_t profile_begin(void) {
+  return profileEnabled || trace_enabled() ? profile_now_ns() : 0;
+}
+
+static inline void profile_end(ProfileZone zone, uint64_t start) {
+  if (profileEnabled || trace_enabled()) {
+    profile_record(zone, start, profile_now_ns());
+  }
+}
+
+// Close the current frame. frameNs is the time since the previous call.
+void profile_frame_end(uint64_t frameNs);
+const char *profile_zone_name(ProfileZone zone);
+// Zone total of the last closed frame
+uint64_t profile_zone_ns(ProfileZone zone);
+// Frame time percentiles over the history, in nanoseconds
+void profile_percentiles(uint64_t *p50, uint64_t *p95, uint64_t *p99);
+void profile_reset(void);
+
+#endif
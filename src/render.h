@@ -0,0 +1,40 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+// Drawing shared by the game loop and the stress benchmark. Everything here
+// is defined in test.c except stress_run.
+
+#include "assetloader.h"
+#include "game.h"
+#include "spritequeue.h"
+
+// Queue the atlas on the loader; nothing can be drawn until it has loaded
+AssetHandle particle_textures_queue(AssetLoader *loader);
+void particle_textures_free();
+// Sprites are queued on spriteQueue, nothing is drawn until it is flushed
+extern SpriteQueue spriteQueue;
+
+void particle_draw(SpriteLayer layer, int archetype, unsigned int frame, int x,
+                   int y);
+void particle_draw_system(ParticleSystem *system, unsigned long tick,
+                          float alpha);
+void powerup_particle_draw_system(ParticleSystem *system, unsigned long tick,
+                                  float alpha);
+void bullet_draw_pool(const BulletPool *pool, float alpha);
+void draw_character(const Player *shark, unsigned long tick, float alpha);
+void healthBar(int health);
+void background_load();
+void background_free();
+void background(unsigned long frameCount);
+
+// Use instead of SetTargetFPS and EndDrawing. With GAME_FRAME_CONTROL the
+// game does the swap, the frame wait and the input poll itself.
+void frame_target(int fps);
+// Call first thing in every frame; waits and polls with --late-latch
+void frame_begin(void);
+void frame_end(void);
+
+// stress.c
+int stress_run(const char *outPath);
+
+#endif
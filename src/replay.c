@@ -0,0 +1,165 @@
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_HEADER_SIZE 20
+
+void replay_init(Replay *replay, unsigned int seed, unsigned int interval) {
+  memset(replay, 0, sizeof(Replay));
+  replay->seed = seed;
+  replay->interval = interval > 0 ? interval : REPLAY_DEFAULT_INTERVAL;
+}
+
+void replay_free(Replay *replay) {
+  free(replay->inputs);
+  free(replay->checksums);
+  replay->inputs = NULL;
+  replay->checksums = NULL;
+}
+
+// Make room for the given number of ticks and the checksums that go with them
+static void replay_reserve(Replay *replay, unsigned long ticks) {
+  if (ticks <= replay->capacity) {
+    return;
+  }
+  unsigned long capacity = replay->capacity ? replay->capacity : 4096;
+  while (capacity < ticks) {
+    capacity *= 2;
+  }
+  replay->inputs = realloc(replay->inputs, capacity);
+  replay->checksums = realloc(replay->checksums,
+                              (capacity / replay->interval + 1) *
+                                  sizeof(uint32_t));
+  replay->capacity = capacity;
+}
+
+void replay_record(Replay *replay, const GameSession *session,
+                   unsigned int input) {
+  replay_reserve(replay, replay->ticks + 1);
+  replay->inputs[replay->ticks++] = input & (INPUT_LEFT | INPUT_RIGHT);
+  if (replay->ticks % replay->interval == 0) {
+    replay->checksums[replay->checksumCount++] = game_checksum(session);
+  }
+}
+
+static void put_u16(unsigned char *out, unsigned int value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+}
+
+static void put_u32(unsigned char *out, uint32_t value) {
+  for (int b = 0; b < 4; b++) {
+    out[b] = (value >> (b * 8)) & 0xFF;
+  }
+}
+
+static unsigned int get_u16(const unsigned char *in) {
+  return in[0] | (in[1] << 8);
+}
+
+static uint32_t get_u32(const unsigned char *in) {
+  return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+bool replay_save(Replay *replay, const GameSession *session, const char *path) {
+  unsigned long checksums = replay->checksumCount + 1;
+  unsigned long inputBytes = (replay->ticks + 3) / 4;
+  unsigned long size = REPLAY_HEADER_SIZE + inputBytes + checksums * 4;
+  unsigned char *data = calloc(size, 1);
+  memcpy(data, "SSRP", 4);
+  put_u16(data + 4, REPLAY_VERSION);
+  put_u16(data + 6, replay->interval);
+  put_u32(data + 8, replay->seed);
+  put_u32(data + 12, (uint32_t)replay->ticks);
+  put_u32(data + 16, (uint32_t)checksums);
+  unsigned char *inputs = data + REPLAY_HEADER_SIZE;
+  for (unsigned long t = 0; t < replay->ticks; t++) {
+    inputs[t / 4] |= replay->inputs[t] << ((t % 4) * 2);
+  }
+  unsigned char *sums = inputs + inputBytes;
+  for (unsigned long c = 0; c < replay->checksumCount; c++) {
+    put_u32(sums + c * 4, replay->checksums[c]);
+  }
+  put_u32(sums + replay->checksumCount * 4, game_checksum(session));
+
+  FILE *file = fopen(path, "wb");
+  bool ok = file != NULL && fwrite(data, 1, size, file) == size;
+  if (file != NULL) {
+    ok = fclose(file) == 0 && ok;
+  }
+  free(data);
+  if (!ok) {
+    game_log(GAME_LOG_WARNING, "REPLAY: Could not write %s\n", path);
+  }
+  return ok;
+}
+
+bool replay_load(Replay *replay, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    game_log(GAME_LOG_WARNING, "REPLAY: Could not open %s\n", path);
+    return false;
+  }
+  unsigned char header[REPLAY_HEADER_SIZE];
+  if (fread(header, 1, REPLAY_HEADER_SIZE, file) != REPLAY_HEADER_SIZE ||
+      memcmp(header, "SSRP", 4) != 0 ||
+      get_u16(header + 4) != REPLAY_VERSION || get_u16(header + 6) == 0) {
+    game_log(GAME_LOG_WARNING, "REPLAY: %s is not a replay file\n", path);
+    fclose(file);
+    return false;
+  }
+  replay_init(replay, get_u32(header + 8), get_u16(header + 6));
+  unsigned long ticks = get_u32(header + 12);
+  unsigned long checksums = get_u32(header + 16);
+  unsigned long inputBytes = (ticks + 3) / 4;
+  if (checksums != ticks / replay->interval + 1) {
+    game_log(GAME_LOG_WARNING, "REPLAY: %s is corrupt\n", path);
+    fclose(file);
+    return false;
+  }
+
+  unsigned long size = inputBytes + checksums * 4;
+  unsigned char *data = malloc(size);
+  bool ok = fread(data, 1, size, file) == size;
+  fclose(file);
+  if (!ok) {
+    game_log(GAME_LOG_WARNING, "REPLAY: %s is truncated\n", path);
+    free(data);
+    return false;
+  }
+  replay_reserve(replay, ticks);
+  for (unsigned long t = 0; t < ticks; t++) {
+    replay->inputs[t] = (data[t / 4] >> ((t % 4) * 2)) & 3;
+  }
+  // the checksum after the last tick is kept at the end of the array
+  replay->checksums = realloc(replay->checksums, checksums * sizeof(uint32_t));
+  for (unsigned long c = 0; c < checksums; c++) {
+    replay->checksums[c] = get_u32(data + inputBytes + c * 4);
+  }
+  replay->ticks = ticks;
+  replay->checksumCount = checksums - 1;
+  free(data);
+  return true;
+}
+
+unsigned int replay_input(const Replay *replay, const GameSession *session) {
+  return session->tick < replay->ticks ? replay->inputs[session->tick] : 0;
+}
+
+bool replay_finished(const Replay *replay, const GameSession *session) {
+  return session->tick >= replay->ticks;
+}
+
+bool replay_verify(const Replay *replay, const GameSession *session) {
+  unsigned long tick = session->tick;
+  if (tick == replay->ticks) {
+    return game_checksum(session) == replay->checksums[replay->checksumCount];
+  }
+  if (tick % replay->interval == 0 && tick / replay->interval > 0 &&
+      tick / replay->interval <= replay->checksumCount) {
+    return game_checksum(session) ==
+           replay->checksums[tick / replay->interval - 1];
+  }
+  return true;
+}
@@ -0,0 +1,46 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// Recorded games. A replay is the seed a session started from plus the input
+// word of every tick, which is all the simulation needs to play the game
+// again bit for bit. A checksum of the world is stored every interval ticks
+// and after the last one so that playback can tell when it has diverged.
+//
+// File layout, all integers little-endian:
+//   "SSRP"  u16 version  u16 interval  u32 seed  u32 ticks  u32 checksums
+//   inputs, 2 bits per tick, four ticks per byte starting at the low bits
+//   u32 checksum after every interval ticks, then one after the last tick
+
+#include "game.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define REPLAY_VERSION 3
+#define REPLAY_DEFAULT_INTERVAL 60
+
+typedef struct {
+  unsigned int seed;
+  unsigned int interval;
+  unsigned long ticks;
+  // one input word per tick, inputs[t] is fed to the tick that makes tick t+1
+  unsigned char *inputs;
+  uint32_t *checksums;
+  unsigned long checksumCount;
+  unsigned long capacity;
+} Replay;
+
+void replay_init(Replay *replay, unsigned int seed, unsigned int interval);
+void replay_free(Replay *replay);
+// Call after each simulation_tick with the input that tick was given
+void replay_record(Replay *replay, const GameSession *session,
+                   unsigned int input);
+bool replay_save(Replay *replay, const GameSession *session, const char *path);
+bool replay_load(Replay *replay, const char *path);
+// Input for the next tick of a session being played back
+unsigned int replay_input(const Replay *replay, const GameSession *session);
+bool replay_finished(const Replay *replay, const GameSession *session);
+// Call after each simulation_tick during playback. Returns false once the
+// session no longer matches the recording.
+bool replay_verify(const Replay *replay, const GameSession *session);
+
+#endif
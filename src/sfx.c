@@ -0,0 +1,171 @@
+#include "sfx.h"
+#include <string.h>
+
+static const SfxCategory soundCategories[SOUND_COUNT] = {
+    [SOUND_PROJECTILE] = SFX_WEAPON,
+    [SOUND_CRATE] = SFX_IMPACT,
+    [SOUND_UMBRELLA] = SFX_IMPACT,
+    [SOUND_YUMMY] = SFX_PICKUP,
+};
+
+// The harpoon fires every second, so it is kept under the rest
+static const float soundVolumes[SOUND_COUNT] = {
+    [SOUND_PROJECTILE] = 0.4f,
+    [SOUND_CRATE] = 0.7f,
+    [SOUND_UMBRELLA] = 0.7f,
+    [SOUND_YUMMY] = 0.7f,
+};
+
+// These add up to SFX_MAX_VOICES
+static const int categoryVoices[SFX_CATEGORY_COUNT] = {
+    [SFX_WEAPON] = 3,
+    [SFX_IMPACT] = 4,
+    [SFX_PICKUP] = 3,
+};
+
+// Effects from the asset pack play straight from its PCM; without a pack
+// the file is decoded on the loader thread
+typedef struct {
+  Sfx *sfx;
+  SoundId sound;
+  const AssetPack *pack;
+  Wave wave;
+  bool fromPack;
+} SfxLoad;
+
+static SfxLoad loads[SOUND_COUNT];
+
+void sfx_init(Sfx *sfx) { memset(sfx, 0, sizeof(Sfx)); }
+
+static bool sfx_decode(void *user) {
+  SfxLoad *load = user;
+  const AssetEntry *entry =
+      asset_pack_find(load->pack, soundNames[load->sound], ASSET_SOUND_PCM);
+  load->fromPack = entry != NULL;
+  if (load->fromPack) {
+    asset_pack_prefetch(load->pack, entry);
+    load->wave = (Wave){.frameCount = entry->frameCount,
+                        .sampleRate = entry->sampleRate,
+                        .sampleSize = entry->sampleSize,
+                        .channels = entry->channels,
+                        .data = (void *)asset_pack_data(load->pack, entry)};
+    return true;
+  }
+  char path[ASSET_PATH_MAX];
+  load->wave = LoadWave(asset_source_path(path, sizeof(path), ASSET_SOURCE_DIR,
+                                          soundFiles[load->sound]));
+  return IsWaveValid(load->wave);
+}
+
+static bool sfx_upload(void *user, bool decoded) {
+  SfxLoad *load = user;
+  if (!decoded) {
+    return false;
+  }
+  SfxEffect *effect = &load->sfx->effects[load->sound];
+  // raylib converts the samples into a buffer of its own
+  effect->source = LoadSoundFromWave(load->wave);
+  if (!load->fromPack) {
+    UnloadWave(load->wave);
+  }
+  if (!IsSoundValid(effect->source)) {
+    return false;
+  }
+  effect->voiceCount = categoryVoices[soundCategories[load->sound]];
+  for (int v = 0; v < effect->voiceCount; v++) {
+    effect->voices[v] = LoadSoundAlias(effect->source);
+    SetSoundVolume(effect->voices[v], soundVolumes[load->sound]);
+  }
+  effect->loaded = true;
+  return true;
+}
+
+void sfx_queue(Sfx *sfx, AssetLoader *loader, const AssetPack *pack) {
+  for (int s = 0; s < SOUND_COUNT; s++) {
+    if (s == SOUND_MUSIC) {
+      continue;
+    }
+    loads[s] = (SfxLoad){.sfx = sfx, .sound = s, .pack = pack};
+    asset_loader_add(loader, soundNames[s], sfx_decode, sfx_upload,
+                     &loads[s]);
+  }
+}
+
+void sfx_free(Sfx *sfx) {
+  for (int s = 0; s < SOUND_COUNT; s++) {
+    SfxEffect *effect = &sfx->effects[s];
+    if (!effect->loaded) {
+      continue;
+    }
+    for (int v = 0; v < effect->voiceCount; v++) {
+      UnloadSoundAlias(effect->voices[v]);
+    }
+    UnloadSound(effect->source);
+    effect->loaded = false;
+  }
+}
+
+void sfx_trigger(Sfx *sfx, SoundId sound) {
+  sfx->effects[sound].triggered = true;
+}
+
+// Start one voice of an effect, stopping the oldest voice of its category
+// if the category is already at its cap
+static void sfx_start(Sfx *sfx, SoundId sound) {
+  SfxCategory category = soundCategories[sound];
+  int playing = 0;
+  Sound *oldest = NULL;
+  unsigned long oldestStart = 0;
+  for (int s = 0; s < SOUND_COUNT; s++) {
+    SfxEffect *other = &sfx->effects[s];
+    if (!other->loaded || soundCategories[s] != category) {
+      continue;
+    }
+    for (int v = 0; v < other->voiceCount; v++) {
+      if (!IsSoundPlaying(other->voices[v])) {
+        continue;
+      }
+      playing++;
+      if (oldest == NULL || other->started[v] < oldestStart) {
+        oldest = &other->voices[v];
+        oldestStart = other->started[v];
+      }
+    }
+  }
+  if (playing >= categoryVoices[category]) {
+    StopSound(*oldest);
+  }
+
+  // the category never has more voices going than the effect has aliases,
+  // so after the steal one of them is free
+  SfxEffect *effect = &sfx->effects[sound];
+  for (int v = 0; v < effect->voiceCount; v++) {
+    if (!IsSoundPlaying(effect->voices[v])) {
+      PlaySound(effect->voices[v]);
+      effect->started[v] = sfx->flushes;
+      return;
+    }
+  }
+}
+
+void sfx_flush(Sfx *sfx) {
+  sfx->flushes++;
+  for (int s = 0; s < SOUND_COUNT; s++) {
+    SfxEffect *effect = &sfx->effects[s];
+    if (effect->triggered && effect->loaded) {
+      sfx_start(sfx, s);
+    }
+    effect->triggered = false;
+  }
+}
+
+int sfx_voices_playing(const Sfx *sfx) {
+  int playing = 0;
+  for (int s = 0; s < SOUND_COUNT; s++) {
+    const SfxEffect *effect = &sfx->effects[s];
+    for (int v = 0; v < effect->voiceCount; v++) {
+      playing += effect->loaded && IsSoundPlaying(effect->voices[v]);
+    }
+  }
+  return playing;
+}
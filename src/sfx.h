@@ -0,0 +1,58 @@
+#ifndef SFX_H
+#define SFX_H
+
+// Sound effects on a fixed set of voices. Each effect is loaded once and
+// played through aliases of it (LoadSoundAlias), which share its samples.
+// Effects belong to a category with a cap on how many of its voices may
+// sound at once; a trigger past the cap stops the category's oldest voice
+// to make room. Triggers are only collected by sfx_trigger, and sfx_flush
+// starts each effect triggered since the last flush once, so a hundred hits
+// in one tick cost one voice. However busy the game gets, the mixer never
+// has more than SFX_MAX_VOICES sounds to mix.
+
+#include "assetloader.h"
+#include "assetpack.h"
+#include "assets.h"
+#include "raylib.h"
+
+typedef enum {
+  SFX_WEAPON = 0,
+  SFX_IMPACT,
+  SFX_PICKUP,
+  SFX_CATEGORY_COUNT
+} SfxCategory;
+
+// The most voices any one category is allowed
+#define SFX_MAX_CATEGORY_VOICES 4
+// Sum of the category caps in sfx.c
+#define SFX_MAX_VOICES 10
+
+typedef struct {
+  Sound source;
+  // one alias per voice the effect's category allows
+  Sound voices[SFX_MAX_CATEGORY_VOICES];
+  // when each voice was started, in sfx_flush calls, to find the oldest
+  unsigned long started[SFX_MAX_CATEGORY_VOICES];
+  int voiceCount;
+  bool loaded;
+  bool triggered;
+} SfxEffect;
+
+typedef struct {
+  // indexed by SoundId; the music entry is never loaded
+  SfxEffect effects[SOUND_COUNT];
+  unsigned long flushes;
+} Sfx;
+
+void sfx_init(Sfx *sfx);
+// Queue every effect on the loader, from the pack if it has them. Each one
+// plays once it has loaded.
+void sfx_queue(Sfx *sfx, AssetLoader *loader, const AssetPack *pack);
+void sfx_free(Sfx *sfx);
+void sfx_trigger(Sfx *sfx, SoundId sound);
+// Start what was triggered since the last flush, once per tick
+void sfx_flush(Sfx *sfx);
+// Voices sounding right now
+int sfx_voices_playing(const Sfx *sfx);
+
+#endif
@@ -0,0 +1,220 @@
+// Headless game runner. Plays whole sessions through the simulation core as
+// fast as the CPU allows, with no window, audio device or frame pacing.
+//
+//   gameSim [--sessions N] [--seed S] [--max-ticks T] [--input MODE]
+//           [--record FILE | --replay FILE] [--trace FILE]
+//           [--save-state TICK FILE] [--load-state FILE]
+//
+// MODE is "random" (default), "idle", or the path of an input script. A
+// script has one "<ticks> <keys>" pair per line, where keys is L, R, LR or -,
+// and is replayed in a loop for the whole session.
+//
+// --record FILE saves the first session as a replay. --replay FILE plays a
+// recorded game instead, checking it against the recorded checksums; with
+// --sessions N it is played N times, which makes a fixed benchmark workload.
+// --trace FILE writes the simulation zones of every tick as a Chrome trace.
+//
+// --save-state TICK FILE snapshots the first session after TICK ticks and
+// reports how long saving and restoring took. --load-state FILE starts the
+// first session, or every replayed one, from a snapshot instead of tick 0;
+// with --replay that plays a recording on from the middle.
+#include "bot.h"
+#include "game.h"
+#include "profile.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static InputScript script;
+
+// Snapshot the session to path, then time a save and a restore into a second
+// session and check that the copy matches.
+static bool save_state(const GameSession *session, const char *path) {
+  if (!snapshot_save_file(session, path)) {
+    return false;
+  }
+  size_t size = snapshot_size(session);
+  unsigned char *data = malloc(size);
+  GameSession *copy = game_session_create(0);
+  uint64_t start = profile_now_ns();
+  snapshot_save(session, data, size);
+  uint64_t saved = profile_now_ns();
+  bool ok = snapshot_restore(copy, data, size);
+  uint64_t restored = profile_now_ns();
+  ok = ok && game_checksum(copy) == game_checksum(session);
+  fprintf(stderr,
+          "gameSim: snapshot of %zu bytes at tick %lu, saved in %.1f us, "
+          "restored in %.1f us%s\n",
+          size, session->tick, (saved - start) / 1e3, (restored - saved) / 1e3,
+          ok ? "" : ", COPY DIFFERS");
+  game_session_free(copy);
+  free(data);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  int sessions = 1;
+  unsigned int seed = 1;
+  unsigned long maxTicks = 10UL * 60 * TICK_RATE;
+  InputMode mode = INPUT_MODE_RANDOM;
+  const char *recordPath = NULL;
+  Replay replay;
+  bool playback = false;
+  unsigned long saveTick = 0;
+  const char *savePath = NULL;
+  const char *loadPath = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+      sessions = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) {
+      maxTicks = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+      const char *value = argv[++i];
+      if (strcmp(value, "random") == 0) {
+        mode = INPUT_MODE_RANDOM;
+      } else if (strcmp(value, "idle") == 0) {
+        mode = INPUT_MODE_IDLE;
+      } else if (input_script_load(&script, value)) {
+        mode = INPUT_MODE_SCRIPT;
+      } else {
+        fprintf(stderr, "gameSim: cannot read input script %s\n", value);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      recordPath = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      if (!replay_load(&replay, argv[++i])) {
+        fprintf(stderr, "gameSim: cannot read replay %s\n", argv[i]);
+        return 1;
+      }
+      playback = true;
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      if (!trace_open(argv[++i])) {
+        fprintf(stderr, "gameSim: cannot write trace %s\n", argv[i]);
+        return 1;
+      }
+      trace_thread_name("simulation");
+    } else if (strcmp(argv[i], "--save-state") == 0 && i + 2 < argc) {
+      saveTick = strtoul(argv[++i], NULL, 10);
+      savePath = argv[++i];
+    } else if (strcmp(argv[i], "--load-state") == 0 && i + 1 < argc) {
+      loadPath = argv[++i];
+    } else {
+      fprintf(stderr,
+              "usage: %s [--sessions N] [--seed S] [--max-ticks T] "
+              "[--input random|idle|FILE] [--record FILE | --replay FILE] "
+              "[--trace FILE] [--save-state TICK FILE] [--load-state FILE]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  // a replay starts from its seed alone, so it cannot start from a snapshot
+  if (recordPath != NULL && loadPath != NULL) {
+    fprintf(stderr, "gameSim: --record cannot start from --load-state\n");
+    return 1;
+  }
+
+  gameLogLevel = GAME_LOG_WARNING;
+  log_start();
+  if (!game_init()) {
+    fprintf(stderr, "gameSim: cannot load the game data table\n");
+    log_stop();
+    return 1;
+  }
+  GameSession *session = game_session_create(seed);
+
+  printf("seed,ticks,score,health\n");
+  unsigned long totalTicks = 0;
+  bool desync = false;
+  clock_t start = clock();
+  for (int s = 0; s < sessions; s++) {
+    if (playback) {
+      game_session_reset(session, replay.seed);
+      if (loadPath != NULL && !snapshot_load_file(session, loadPath)) {
+        fprintf(stderr, "gameSim: cannot restore %s\n", loadPath);
+        log_stop();
+        return 1;
+      }
+      while (!replay_finished(&replay, session)) {
+        simulation_tick(session, replay_input(&replay, session));
+        if (!replay_verify(&replay, session)) {
+          fprintf(stderr, "gameSim: replay diverged at tick %lu\n",
+                  session->tick);
+          desync = true;
+          break;
+        }
+      }
+      totalTicks += session->tick;
+      printf("%u,%lu,%lu,%d\n", replay.seed, session->tick, session->score,
+             session->shark.health);
+      trace_flush();
+      if (desync) {
+        break;
+      }
+      continue;
+    }
+
+    unsigned int sessionSeed = seed + s;
+    game_session_reset(session, sessionSeed);
+    if (loadPath != NULL && s == 0 && !snapshot_load_file(session, loadPath)) {
+      fprintf(stderr, "gameSim: cannot restore %s\n", loadPath);
+      log_stop();
+      return 1;
+    }
+    InputSource source;
+    input_source_init(&source, mode, &script, sessionSeed);
+    bool recording = recordPath != NULL && s == 0;
+    if (recording) {
+      replay_init(&replay, sessionSeed, REPLAY_DEFAULT_INTERVAL);
+    }
+
+    while (!game_over(session) && session->tick < maxTicks) {
+      unsigned int input = input_next(&source);
+      simulation_tick(session, input);
+      if (recording) {
+        replay_record(&replay, session, input);
+      }
+      if (savePath != NULL && s == 0 && session->tick == saveTick &&
+          !save_state(session, savePath)) {
+        fprintf(stderr, "gameSim: cannot save state to %s\n", savePath);
+        log_stop();
+        return 1;
+      }
+    }
+    if (recording) {
+      bool saved = replay_save(&replay, session, recordPath);
+      replay_free(&replay);
+      if (!saved) {
+        fprintf(stderr, "gameSim: cannot write replay %s\n", recordPath);
+        log_stop();
+        return 1;
+      }
+    }
+    trace_flush();
+    totalTicks += session->tick;
+    printf("%u,%lu,%lu,%d\n", sessionSeed, session->tick, session->score,
+           session->shark.health);
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  fprintf(stderr,
+          "gameSim: %d sessions, %lu ticks in %.3f s (%.0f ticks/s, %.0f "
+          "sessions/min)\n",
+          sessions, totalTicks, seconds,
+          seconds > 0 ? totalTicks / seconds : 0.0,
+          seconds > 0 ? sessions * 60.0 / seconds : 0.0);
+
+  trace_close();
+  game_session_free(session);
+  if (playback) {
+    replay_free(&replay);
+  }
+  log_stop();
+  return desync ? 1 : 0;
+}
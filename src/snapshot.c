@@ -0,0 +1,365 @@
+#include "snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_HEADER_SIZE 12
+// bytes per live particle, per free slot and per bullet
+#define SNAPSHOT_PARTICLE_SIZE 31
+#define SNAPSHOT_SLOT_SIZE 2
+#define SNAPSHOT_BULLET_SIZE 17
+
+static unsigned char *put_u8(unsigned char *out, unsigned int value) {
+  out[0] = value & 0xFF;
+  return out + 1;
+}
+
+static unsigned char *put_u16(unsigned char *out, unsigned int value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+  return out + 2;
+}
+
+static unsigned char *put_u32(unsigned char *out, uint32_t value) {
+  for (int b = 0; b < 4; b++) {
+    out[b] = (value >> (b * 8)) & 0xFF;
+  }
+  return out + 4;
+}
+
+static unsigned char *put_u64(unsigned char *out, uint64_t value) {
+  for (int b = 0; b < 8; b++) {
+    out[b] = (value >> (b * 8)) & 0xFF;
+  }
+  return out + 8;
+}
+
+static unsigned char *put_f64(unsigned char *out, double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return put_u64(out, bits);
+}
+
+// Reading stops at the end of the data; every read after that returns 0 and
+// leaves ok false, so callers check once at the end.
+typedef struct {
+  const unsigned char *p;
+  const unsigned char *end;
+  bool ok;
+} SnapshotReader;
+
+static uint64_t get_bytes(SnapshotReader *in, int bytes) {
+  if (in->end - in->p < bytes) {
+    in->ok = false;
+    in->p = in->end;
+    return 0;
+  }
+  uint64_t value = 0;
+  for (int b = 0; b < bytes; b++) {
+    value |= (uint64_t)in->p[b] << (b * 8);
+  }
+  in->p += bytes;
+  return value;
+}
+
+static double get_f64(SnapshotReader *in) {
+  uint64_t bits = get_bytes(in, 8);
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+size_t snapshot_size(const GameSession *session) {
+  const ParticleSystem *systems[] = {&session->enemies, &session->bosses,
+                                     &session->powerups,
+                                     &session->projectiles};
+  size_t size = SNAPSHOT_HEADER_SIZE + 8 * 3 + 4 + 8 + 8 * 2 + 4 * 5 +
+                4 * ARCHETYPE_COUNT;
+  for (int s = 0; s < 4; s++) {
+    size += 2 + systems[s]->count * SNAPSHOT_PARTICLE_SIZE;
+    size += 2 + systems[s]->freeCount * SNAPSHOT_SLOT_SIZE;
+  }
+  size += 4 + session->bullets.count * SNAPSHOT_BULLET_SIZE;
+  return size;
+}
+
+static unsigned char *save_system(unsigned char *out,
+                                  const ParticleSystem *system) {
+  out = put_u16(out, system->count);
+  for (int k = 0; k < system->count; k++) {
+    int i = system->alive[k];
+    out = put_u16(out, i);
+    out = put_u8(out, system->archetype[i]);
+    out = put_u32(out, system->x[i]);
+    out = put_u32(out, system->y[i]);
+    out = put_u32(out, system->dy[i]);
+    out = put_u32(out, system->health[i]);
+    out = put_u32(out, system->type[i]);
+    out = put_u64(out, system->phase[i]);
+  }
+  out = put_u16(out, system->freeCount);
+  for (int f = 0; f < system->freeCount; f++) {
+    out = put_u16(out, system->freeSlots[f]);
+  }
+  return out;
+}
+
+size_t snapshot_save(const GameSession *session, unsigned char *out,
+                     size_t capacity) {
+  size_t size = snapshot_size(session);
+  if (size > capacity) {
+    return 0;
+  }
+  unsigned char *p = out;
+  memcpy(p, "SSSN", 4);
+  p = put_u16(p + 4, SNAPSHOT_VERSION);
+  p = put_u16(p, session->enemies.capacity);
+  p = put_u32(p, (uint32_t)size);
+
+  p = put_u64(p, session->tick);
+  p = put_u64(p, session->score);
+  p = put_u64(p, session->nextPatternTime);
+  p = put_u32(p, session->lastInterval);
+  p = put_u64(p, session->rngState);
+  p = put_f64(p, session->sharkAcceleration);
+  p = put_f64(p, session->projectileInterval);
+  p = put_u32(p, session->shark.x);
+  p = put_u32(p, session->shark.y);
+  p = put_u32(p, session->shark.prevX);
+  p = put_u32(p, session->shark.health);
+  p = put_u32(p, session->bulletGraceTicks);
+  for (int a = 0; a < ARCHETYPE_COUNT; a++) {
+    p = put_u32(p, session->damageBy[a]);
+  }
+
+  p = save_system(p, &session->enemies);
+  p = save_system(p, &session->bosses);
+  p = save_system(p, &session->powerups);
+  p = save_system(p, &session->projectiles);
+
+  const BulletPool *bullets = &session->bullets;
+  p = put_u32(p, bullets->count);
+  for (int i = 0; i < bullets->count; i++) {
+    p = put_u32(p, bullets->x[i]);
+    p = put_u32(p, bullets->y[i]);
+    p = put_u32(p, bullets->vx[i]);
+    p = put_u32(p, bullets->vy[i]);
+    p = put_u8(p, bullets->owner[i]);
+  }
+  return size;
+}
+
+// Claim slot i in seen, failing the read if it is out of range or was
+// already claimed; seen is NULL when applying a checked snapshot
+static bool claim_slot(SnapshotReader *in, unsigned char *seen, int i,
+                       int capacity) {
+  if (i >= capacity || (seen != NULL && seen[i])) {
+    in->ok = false;
+    return false;
+  }
+  if (seen != NULL) {
+    seen[i] = 1;
+  }
+  return true;
+}
+
+// Read one particle system. With apply false the data is only checked, so a
+// bad snapshot is found before anything in the session has been changed.
+// Every slot must be either alive or free, exactly once.
+static void restore_system(SnapshotReader *in, ParticleSystem *system,
+                           bool apply) {
+  int count = (int)get_bytes(in, 2);
+  if (count > system->capacity) {
+    in->ok = false;
+    return;
+  }
+  unsigned char *seen = NULL;
+  if (!apply) {
+    seen = calloc(system->capacity, 1);
+    if (seen == NULL) {
+      in->ok = false;
+      return;
+    }
+  }
+  if (apply) {
+    for (int i = 0; i < system->capacity; i++) {
+      system->isAlive[i] = false;
+    }
+    system->count = count;
+  }
+  for (int k = 0; k < count && in->ok; k++) {
+    int i = (int)get_bytes(in, 2);
+    int archetype = (int)get_bytes(in, 1);
+    if (!claim_slot(in, seen, i, system->capacity) ||
+        archetype >= ARCHETYPE_COUNT) {
+      in->ok = false;
+      break;
+    }
+    int x = (int32_t)get_bytes(in, 4);
+    int y = (int32_t)get_bytes(in, 4);
+    int dy = (int32_t)get_bytes(in, 4);
+    int health = (int32_t)get_bytes(in, 4);
+    ParticleType type = (ParticleType)get_bytes(in, 4);
+    unsigned long phase = (unsigned long)get_bytes(in, 8);
+    if (apply) {
+      system->alive[k] = i;
+      system->archetype[i] = archetype;
+      system->x[i] = x;
+      system->y[i] = y;
+      system->dy[i] = dy;
+      system->health[i] = health;
+      system->type[i] = type;
+      system->phase[i] = phase;
+      system->isAlive[i] = true;
+    }
+  }
+  int freeCount = in->ok ? (int)get_bytes(in, 2) : 0;
+  if (count + freeCount != system->capacity) {
+    in->ok = false;
+  }
+  if (apply && in->ok) {
+    system->freeCount = freeCount;
+  }
+  for (int f = 0; f < freeCount && in->ok; f++) {
+    int i = (int)get_bytes(in, 2);
+    if (!claim_slot(in, seen, i, system->capacity)) {
+      break;
+    }
+    if (apply) {
+      system->freeSlots[f] = i;
+    }
+  }
+  free(seen);
+}
+
+static bool restore(GameSession *session, const unsigned char *data,
+                    size_t size, bool apply) {
+  SnapshotReader in = {data + SNAPSHOT_HEADER_SIZE, data + size, true};
+  unsigned long tick = (unsigned long)get_bytes(&in, 8);
+  unsigned long score = (unsigned long)get_bytes(&in, 8);
+  unsigned long nextPatternTime = (unsigned long)get_bytes(&in, 8);
+  unsigned int lastInterval = (unsigned int)get_bytes(&in, 4);
+  uint64_t rngState = get_bytes(&in, 8);
+  double sharkAcceleration = get_f64(&in);
+  double projectileInterval = get_f64(&in);
+  Player shark;
+  shark.x = (int32_t)get_bytes(&in, 4);
+  shark.y = (int32_t)get_bytes(&in, 4);
+  shark.prevX = (int32_t)get_bytes(&in, 4);
+  shark.health = (int32_t)get_bytes(&in, 4);
+  int bulletGraceTicks = (int32_t)get_bytes(&in, 4);
+  if (bulletGraceTicks < 0 || bulletGraceTicks > BULLET_GRACE_TICKS) {
+    return false;
+  }
+  unsigned int damageBy[ARCHETYPE_COUNT];
+  for (int a = 0; a < ARCHETYPE_COUNT; a++) {
+    damageBy[a] = (unsigned int)get_bytes(&in, 4);
+  }
+  if (apply) {
+    session->tick = tick;
+    session->score = score;
+    session->nextPatternTime = nextPatternTime;
+    session->lastInterval = lastInterval;
+    session->rngState = rngState;
+    session->sharkAcceleration = sharkAcceleration;
+    session->projectileInterval = projectileInterval;
+    session->shark = shark;
+    session->bulletGraceTicks = bulletGraceTicks;
+    memcpy(session->damageBy, damageBy, sizeof(damageBy));
+  }
+
+  restore_system(&in, &session->enemies, apply);
+  restore_system(&in, &session->bosses, apply);
+  restore_system(&in, &session->powerups, apply);
+  restore_system(&in, &session->projectiles, apply);
+
+  BulletPool *bullets = &session->bullets;
+  int count = (int)get_bytes(&in, 4);
+  if (count > bullets->capacity ||
+      in.end - in.p != (ptrdiff_t)count * SNAPSHOT_BULLET_SIZE) {
+    return false;
+  }
+  if (apply) {
+    bullets->count = count;
+  }
+  for (int i = 0; i < count; i++) {
+    int x = (int32_t)get_bytes(&in, 4);
+    int y = (int32_t)get_bytes(&in, 4);
+    int vx = (int32_t)get_bytes(&in, 4);
+    int vy = (int32_t)get_bytes(&in, 4);
+    int owner = (int)get_bytes(&in, 1);
+    // the owner indexes damageBy when the bullet lands
+    if (owner >= ARCHETYPE_COUNT) {
+      return false;
+    }
+    if (apply) {
+      bullets->x[i] = x;
+      bullets->y[i] = y;
+      bullets->vx[i] = vx;
+      bullets->vy[i] = vy;
+      bullets->owner[i] = (unsigned char)owner;
+    }
+  }
+  return in.ok;
+}
+
+bool snapshot_restore(GameSession *session, const unsigned char *data,
+                      size_t size) {
+  if (size < SNAPSHOT_HEADER_SIZE || memcmp(data, "SSSN", 4) != 0) {
+    game_log(GAME_LOG_WARNING, "SNAPSHOT: Not a snapshot\n");
+    return false;
+  }
+  SnapshotReader header = {data + 4, data + SNAPSHOT_HEADER_SIZE, true};
+  unsigned int version = (unsigned int)get_bytes(&header, 2);
+  int capacity = (int)get_bytes(&header, 2);
+  size_t stored = (size_t)get_bytes(&header, 4);
+  if (version != SNAPSHOT_VERSION) {
+    game_log(GAME_LOG_WARNING, "SNAPSHOT: Version %u, expected %d\n",
+             version, SNAPSHOT_VERSION);
+    return false;
+  }
+  if (capacity != session->enemies.capacity) {
+    game_log(GAME_LOG_WARNING,
+             "SNAPSHOT: Taken with %d particles per system, session has %d\n",
+             capacity, session->enemies.capacity);
+    return false;
+  }
+  if (stored != size || !restore(session, data, size, false)) {
+    game_log(GAME_LOG_WARNING, "SNAPSHOT: Corrupt snapshot\n");
+    return false;
+  }
+  return restore(session, data, size, true);
+}
+
+bool snapshot_save_file(const GameSession *session, const char *path) {
+  size_t size = snapshot_size(session);
+  unsigned char *data = malloc(size);
+  snapshot_save(session, data, size);
+  FILE *file = fopen(path, "wb");
+  bool ok = file != NULL && fwrite(data, 1, size, file) == size;
+  if (file != NULL) {
+    ok = fclose(file) == 0 && ok;
+  }
+  free(data);
+  if (!ok) {
+    game_log(GAME_LOG_WARNING, "SNAPSHOT: Could not write %s\n", path);
+  }
+  return ok;
+}
+
+bool snapshot_load_file(GameSession *session, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    game_log(GAME_LOG_WARNING, "SNAPSHOT: Could not open %s\n", path);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  unsigned char *data = malloc(size > 0 ? size : 1);
+  bool ok = size > 0 && fread(data, 1, size, file) == (size_t)size;
+  fclose(file);
+  ok = ok && snapshot_restore(session, data, size);
+  free(data);
+  return ok;
+}
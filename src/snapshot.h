@@ -0,0 +1,42 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+// Whole-session snapshots. A snapshot holds everything simulation_tick reads
+// or writes, so restoring one and feeding the same input plays on exactly as
+// the original session did: checkpoints while tuning, rewinding, or jumping
+// into the middle of a replay. Particles are stored by archetype id and only
+// the live ones are written, so a snapshot is a few kilobytes.
+//
+// Layout, all integers little-endian:
+//   "SSSN"  u16 version  u16 capacity  u32 size
+//   u64 tick  u64 score  u64 nextPatternTime  u32 lastInterval  u64 rngState
+//   f64 sharkAcceleration  f64 projectileInterval
+//   i32 shark x, y, prevX, health  i32 bulletGraceTicks
+//   u32 damageBy[ARCHETYPE_COUNT]
+//   per particle system, enemies, bosses, powerups then projectiles:
+//     u16 count, then per live particle in alive order:
+//       u16 slot  u8 archetype  i32 x, y, dy, health  u32 type  u64 phase
+//     u16 freeCount, then the free slot stack bottom to top as u16
+//   u32 bullet count, then per bullet: i32 x, y, vx, vy  u8 owner
+
+#include "game.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SNAPSHOT_VERSION 2
+
+// Bytes needed to snapshot the session as it is now
+size_t snapshot_size(const GameSession *session);
+// Write a snapshot into out. Returns the bytes written, or 0 if it does not
+// fit in capacity bytes.
+size_t snapshot_save(const GameSession *session, unsigned char *out,
+                     size_t capacity);
+// Put a session back to the state in a snapshot. The session must have been
+// created with the same particle capacity. Returns false, leaving the session
+// untouched, if the data is not a snapshot this build can restore.
+bool snapshot_restore(GameSession *session, const unsigned char *data,
+                      size_t size);
+bool snapshot_save_file(const GameSession *session, const char *path);
+bool snapshot_load_file(GameSession *session, const char *path);
+
+#endif
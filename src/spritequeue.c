@@ -0,0 +1,118 @@
+#include "spritequeue.h"
+#include "trace.h"
+#include <stdlib.h>
+
+void sprite_queue_init(SpriteQueue *queue, int capacity) {
+  queue->commands = malloc(capacity * sizeof(SpriteCommand));
+  queue->keys = malloc(capacity * sizeof(unsigned short));
+  queue->order = malloc(capacity * sizeof(int));
+  queue->scratch = malloc(capacity * sizeof(int));
+  queue->capacity = capacity;
+  queue->count = 0;
+  queue->textureCount = 0;
+  queue->unsortedBatches = 0;
+  queue->sortedBatches = 0;
+}
+
+void sprite_queue_free(SpriteQueue *queue) {
+  free(queue->commands);
+  free(queue->keys);
+  free(queue->order);
+  free(queue->scratch);
+}
+
+// Frames only get busier a few times per run, so the arrays double when full
+// and are never shrunk
+static void sprite_queue_grow(SpriteQueue *queue) {
+  int capacity = queue->capacity * 2;
+  TraceLog(LOG_DEBUG, "SPRITEQUEUE: Growing to %d commands", capacity);
+  queue->commands = realloc(queue->commands, capacity * sizeof(SpriteCommand));
+  queue->keys = realloc(queue->keys, capacity * sizeof(unsigned short));
+  queue->order = realloc(queue->order, capacity * sizeof(int));
+  queue->scratch = realloc(queue->scratch, capacity * sizeof(int));
+  queue->capacity = capacity;
+}
+
+static int sprite_queue_texture_slot(SpriteQueue *queue, Texture2D texture) {
+  // a frame uses a handful of textures, so a linear search is the fast path
+  for (int t = 0; t < queue->textureCount; t++) {
+    if (queue->textures[t].id == texture.id) {
+      return t;
+    }
+  }
+  if (queue->textureCount == SPRITE_QUEUE_MAX_TEXTURES) {
+    sprite_queue_flush(queue);
+  }
+  queue->textures[queue->textureCount] = texture;
+  return queue->textureCount++;
+}
+
+void sprite_queue_push(SpriteQueue *queue, SpriteLayer layer,
+                       Texture2D texture, Rectangle source, Rectangle dest,
+                       Color tint) {
+  int slot = sprite_queue_texture_slot(queue, texture);
+  if (queue->count == queue->capacity) {
+    sprite_queue_grow(queue);
+  }
+  int i = queue->count++;
+  queue->commands[i] =
+      (SpriteCommand){source, dest, tint, (unsigned char)slot};
+  queue->keys[i] = (unsigned short)(layer << 8 | slot);
+}
+
+// One counting pass of an LSD radix sort on the byte of the key at shift.
+// Counting sort is stable, so sorting on the texture byte and then on the
+// layer byte orders by layer, then texture, then push order.
+static void sprite_queue_radix_pass(const unsigned short *keys,
+                                    const int *in, int *out, int count,
+                                    int shift) {
+  int offsets[256] = {0};
+  for (int i = 0; i < count; i++) {
+    offsets[(keys[in[i]] >> shift) & 0xFF]++;
+  }
+  int total = 0;
+  for (int b = 0; b < 256; b++) {
+    int n = offsets[b];
+    offsets[b] = total;
+    total += n;
+  }
+  for (int i = 0; i < count; i++) {
+    out[offsets[(keys[in[i]] >> shift) & 0xFF]++] = in[i];
+  }
+}
+
+static int sprite_queue_count_batches(const SpriteQueue *queue,
+                                      const int *order) {
+  int batches = 0;
+  int texture = -1;
+  for (int i = 0; i < queue->count; i++) {
+    const SpriteCommand *c = &queue->commands[order ? order[i] : i];
+    if (c->texture != texture) {
+      texture = c->texture;
+      batches++;
+    }
+  }
+  return batches;
+}
+
+void sprite_queue_flush(SpriteQueue *queue) {
+  TRACE_SCOPE("sprite_queue_flush");
+  for (int i = 0; i < queue->count; i++) {
+    queue->scratch[i] = i;
+  }
+  sprite_queue_radix_pass(queue->keys, queue->scratch, queue->order,
+                          queue->count, 0);
+  sprite_queue_radix_pass(queue->keys, queue->order, queue->scratch,
+                          queue->count, 8);
+  const int *order = queue->scratch;
+  queue->unsortedBatches = sprite_queue_count_batches(queue, NULL);
+  queue->sortedBatches = sprite_queue_count_batches(queue, order);
+
+  for (int i = 0; i < queue->count; i++) {
+    const SpriteCommand *c = &queue->commands[order[i]];
+    DrawTexturePro(queue->textures[c->texture], c->source, c->dest,
+                   (Vector2){0, 0}, 0.0f, c->tint);
+  }
+  queue->count = 0;
+  queue->textureCount = 0;
+}
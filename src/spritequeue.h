@@ -0,0 +1,59 @@
+#ifndef SPRITEQUEUE_H
+#define SPRITEQUEUE_H
+
+// Sprites for a frame are pushed here instead of being drawn on the spot.
+// sprite_queue_flush sorts them by layer, then by texture inside a layer, and
+// draws them in that order, so each texture is bound at most once per layer
+// however the pushes were interleaved. Within one layer and texture the push
+// order is kept, so sprites of the same sheet still overlap as they did.
+
+#include "raylib.h"
+
+// Back to front
+typedef enum {
+  SPRITE_LAYER_GROUND = 0,
+  SPRITE_LAYER_SCENERY,
+  SPRITE_LAYER_PARTICLES,
+  SPRITE_LAYER_BULLETS,
+  SPRITE_LAYER_CHARACTER,
+  SPRITE_LAYER_HUD,
+  SPRITE_LAYER_COUNT
+} SpriteLayer;
+
+// Distinct textures one frame may use
+#define SPRITE_QUEUE_MAX_TEXTURES 256
+
+typedef struct {
+  Rectangle source;
+  Rectangle dest;
+  Color tint;
+  unsigned char texture;
+} SpriteCommand;
+
+typedef struct {
+  SpriteCommand *commands;
+  // sort key of each command, layer in the high byte and texture slot in the
+  // low byte, and the command order the radix sort produces
+  unsigned short *keys;
+  int *order;
+  int *scratch;
+  int count;
+  int capacity;
+  // textures pushed this frame, a command names one by its slot here
+  Texture2D textures[SPRITE_QUEUE_MAX_TEXTURES];
+  int textureCount;
+  // texture changes the last flush would have made in push order, and the
+  // ones it made after sorting
+  int unsortedBatches;
+  int sortedBatches;
+} SpriteQueue;
+
+void sprite_queue_init(SpriteQueue *queue, int capacity);
+void sprite_queue_free(SpriteQueue *queue);
+void sprite_queue_push(SpriteQueue *queue, SpriteLayer layer,
+                       Texture2D texture, Rectangle source, Rectangle dest,
+                       Color tint);
+// Sort and draw everything pushed since the last flush, then empty the queue
+void sprite_queue_flush(SpriteQueue *queue);
+
+#endif
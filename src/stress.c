@@ -0,0 +1,172 @@
+// Stress benchmark, run with gameTest --stress FILE. Each level keeps the
+// given number of particles alive in every particle system, and as many boss
+// bullets in flight, and times the update, collision and render passes over a
+// fixed number of frames, so the numbers only move when the particle,
+// collision or drawing code does.
+#include "game.h"
+#include "profile.h"
+#include "raylib.h"
+#include "render.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STRESS_SEED 1
+#define STRESS_WARMUP_FRAMES 30
+#define STRESS_FRAMES 300
+
+static const int stressLevels[] = {100, 500, 2000, 10000};
+
+typedef enum {
+  STRESS_UPDATE = 0,
+  STRESS_COLLISION,
+  STRESS_RENDER,
+  STRESS_PHASES
+} StressPhase;
+
+static const char *phaseNames[STRESS_PHASES] = {"update", "collision",
+                                                "render"};
+
+// Spawn at a random spot on screen until the system holds count particles
+static void stress_fill(GameSession *session, ParticleSystem *system,
+                        int count) {
+  while (system->count < count) {
+    int x = game_random(session, 0, SCREEN_WIDTH - 64);
+    int y = game_random(session, 0, SCREEN_HEIGHT - 64);
+    int i;
+    if (system == &session->enemies) {
+      i = particle_enemy_system_create_particle(
+          system, game_random(session, 0, 4), x, session->tick);
+    } else if (system == &session->powerups) {
+      i = particle_power_system_create_particle(
+          system, game_random(session, 1, 5), x, session->tick);
+    } else if (system == &session->bosses) {
+      i = particle_boss_system_create_particle(
+          system, game_random(session, 0, 2), x, session->tick);
+    } else {
+      i = particle_system_spawn(system, ARCHETYPE_HARPOON, x, y,
+                                session->tick);
+    }
+    if (i < 0) {
+      return;
+    }
+    system->y[i] = y;
+  }
+}
+
+// Keep count boss bullets in flight, fired from random spots in random
+// directions
+static void stress_fill_bullets(GameSession *session, int count) {
+  BulletPool *pool = &session->bullets;
+  while (pool->count < count && pool->count < pool->capacity) {
+    int x = game_random(session, 0, SCREEN_WIDTH);
+    int y = game_random(session, 0, SCREEN_HEIGHT);
+    int vx, vy;
+    bullet_direction(game_random(session, 0, 359), 2 << BULLET_SHIFT, &vx,
+                     &vy);
+    bullet_pool_spawn(pool, x, y, vx, vy, ARCHETYPE_KRAKEN);
+  }
+}
+
+static int compare_ns(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static void stress_level(FILE *out, int level) {
+  static uint64_t times[STRESS_PHASES][STRESS_FRAMES];
+  GameSession *session = game_session_create_capacity(STRESS_SEED, level);
+  ParticleSystem *systems[] = {&session->enemies, &session->bosses,
+                               &session->powerups, &session->projectiles};
+  unsigned long alive = 0;
+
+  for (int frame = 0; frame < STRESS_WARMUP_FRAMES + STRESS_FRAMES;
+       frame++) {
+    frame_begin();
+    // the shark cannot die here, and refilling is not part of what is timed
+    session->shark.health = archetypes[ARCHETYPE_SHARK].health;
+    for (int s = 0; s < 4; s++) {
+      stress_fill(session, systems[s], level);
+    }
+    stress_fill_bullets(session, level);
+    unsigned long count = ++session->tick;
+
+    uint64_t start = profile_now_ns();
+    for (int s = 0; s < 4; s++) {
+      particle_update_system(systems[s]);
+    }
+    bullet_pool_update(&session->bullets);
+    uint64_t updated = profile_now_ns();
+    collision_grid_build(&session->grid, &session->enemies,
+                         &session->powerups);
+    player_particle_collision(session);
+    player_projectile_collision(session);
+    player_bullet_collision(session);
+    uint64_t collided = profile_now_ns();
+
+    BeginDrawing();
+    ClearBackground(RAYWHITE);
+    background(count);
+    particle_draw_system(&session->enemies, count, 1.0f);
+    particle_draw_system(&session->bosses, count, 1.0f);
+    powerup_particle_draw_system(&session->powerups, count, 1.0f);
+    particle_draw_system(&session->projectiles, count, 1.0f);
+    bullet_draw_pool(&session->bullets, 1.0f);
+    draw_character(&session->shark, count, 1.0f);
+    healthBar(session->shark.health);
+    sprite_queue_flush(&spriteQueue);
+    DrawText(TextFormat("stress %d", level), 10, 40, 20, BLACK);
+    frame_end();
+    uint64_t rendered = profile_now_ns();
+
+    int f = frame - STRESS_WARMUP_FRAMES;
+    if (f >= 0) {
+      times[STRESS_UPDATE][f] = updated - start;
+      times[STRESS_COLLISION][f] = collided - updated;
+      times[STRESS_RENDER][f] = rendered - collided;
+      for (int s = 0; s < 4; s++) {
+        alive += systems[s]->count;
+      }
+    }
+  }
+
+  fprintf(out, "%d,%lu", level, alive / STRESS_FRAMES);
+  for (int p = 0; p < STRESS_PHASES; p++) {
+    uint64_t total = 0;
+    for (int f = 0; f < STRESS_FRAMES; f++) {
+      total += times[p][f];
+    }
+    qsort(times[p], STRESS_FRAMES, sizeof(uint64_t), compare_ns);
+    fprintf(out, ",%.4f,%.4f,%.4f", total / 1e6 / STRESS_FRAMES,
+            times[p][STRESS_FRAMES / 2] / 1e6,
+            times[p][STRESS_FRAMES * 95 / 100] / 1e6);
+  }
+  fprintf(out, "\n");
+  fflush(out);
+  game_session_free(session);
+}
+
+int stress_run(const char *outPath) {
+  FILE *out = stdout;
+  if (outPath != NULL && (out = fopen(outPath, "w")) == NULL) {
+    game_log(GAME_LOG_WARNING, "STRESS: Could not write %s\n", outPath);
+    return 1;
+  }
+  fprintf(out, "level,alive");
+  for (int p = 0; p < STRESS_PHASES; p++) {
+    fprintf(out, ",%s_mean_ms,%s_p50_ms,%s_p95_ms", phaseNames[p],
+            phaseNames[p], phaseNames[p]);
+  }
+  fprintf(out, "\n");
+  for (unsigned int l = 0; l < sizeof(stressLevels) / sizeof(stressLevels[0]);
+       l++) {
+    if (WindowShouldClose()) {
+      break;
+    }
+    stress_level(out, stressLevels[l]);
+  }
+  if (out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}
@@ -1,768 +1,621 @@
+#include "assetloader.h"
+#include "assetpack.h"
+#include "assets.h"
+#include "atlas.h"
+#include "game.h"
+#include "latency.h"
+#include "music.h"
+#include "pacing.h"
+#include "profile.h"
 #include "raylib.h"
+#include "render.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "rlgl.h"
+#include "sfx.h"
+#include "spritequeue.h"
+#include "trace.h"
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
-#include <strings.h>
-
-#define MAX_PARTICLES 500
-#define SCREEN_WIDTH 640
-#define SCREEN_HEIGHT 960
-
-typedef enum {
-  ENEMY = 0,
-  POWER_UP_HEALTH = 1,
-  POWER_UP_INVIS = 2,
-  POWER_UP_DOUBLE_FIRE_DAMAGE = 4,
-  POWER_UP_DOUBLE_ENEMY_DAMAGE = 8,
-  POWER_UP_SPREAD = 16,
-  BOX = 32,
-  PROJECTILE = 64,
-  BOSS_ORCA = 128,
-  BOSS_EEL = 256,
-  BOSS_KRAKEN = 512,
-  ENEMY_RINGS = 1024,
-  ENEMY_OIL = 2048,
-  ENEMY_STRAW = 4096,
-  ENEMY_JELLYFISH = 4096 * 2,
-  ENEMY_ANCHOR = 4096 * 4,
-  GAP = 4096 * 8,
-  POWERUP = 4096 * 16,
-  CHARACTER_PROJECTILE = 4096 * 32,
-  BOSS_PROJECTILE = 4096 * 64,
-} ParticleType;
-
-#define SINGLE_LINE_PATTERN_COUNT 6
-ParticleType singleLinePatterns[6][12] = {
-    {GAP, ENEMY, GAP, ENEMY, GAP, ENEMY, GAP, ENEMY, GAP, ENEMY, GAP, ENEMY},
-    {GAP, GAP, GAP, ENEMY, GAP, POWERUP, GAP, ENEMY, GAP, GAP},
-    {GAP, GAP, GAP, GAP, GAP, GAP, GAP, GAP, GAP, GAP, GAP, GAP},
-    {GAP, GAP, ENEMY, ENEMY, ENEMY, GAP, GAP, ENEMY, ENEMY, ENEMY, GAP},
-    {POWERUP, GAP, ENEMY, GAP, GAP, ENEMY, ENEMY, ENEMY, GAP, ENEMY, GAP, GAP},
-    {ENEMY, ENEMY, GAP, ENEMY, POWERUP, ENEMY, ENEMY, GAP, ENEMY, POWERUP, GAP,
-     ENEMY}};
-
-#define MULTI_LINE_PATTERN_COUNT 4
-ParticleType multipleLinePattern[4][3][12] = {
-    {{ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY,
-      ENEMY, ENEMY},
-     {ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, BOSS_EEL, ENEMY, ENEMY, ENEMY, ENEMY,
-      ENEMY, ENEMY},
-     {ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, GAP, GAP, ENEMY, ENEMY, ENEMY, ENEMY,
-      ENEMY}},
-
-    {{ENEMY, ENEMY, ENEMY, ENEMY, BOSS_EEL, ENEMY, ENEMY, BOSS_EEL, ENEMY,
-      ENEMY, ENEMY, ENEMY},
-     {ENEMY, ENEMY, ENEMY, ENEMY, GAP, ENEMY, ENEMY, GAP, ENEMY, ENEMY, ENEMY,
-      ENEMY},
-     {ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY,
-      ENEMY, ENEMY}},
-
-    {{ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY,
-      ENEMY, ENEMY},
-     {GAP, GAP, GAP, BOSS_ORCA, GAP, ENEMY, ENEMY, BOSS_ORCA, GAP, GAP, GAP,
-      GAP},
-     {GAP, GAP, GAP, GAP, GAP, ENEMY, ENEMY, GAP, GAP, GAP, GAP, GAP}},
-
-    {{ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY, ENEMY,
-      ENEMY, ENEMY},
-     {GAP, GAP, ENEMY, ENEMY, POWERUP, GAP, GAP, POWERUP, ENEMY, ENEMY, GAP,
-      GAP},
-     {GAP, GAP, GAP, GAP, GAP, GAP, GAP, GAP, GAP, GAP, GAP, GAP}},
-};
+#include <time.h>
+
+// Ticks allowed to catch up after a slow frame before time is dropped
+#define MAX_TICKS_PER_FRAME 5
+// Time a frame may spend uploading loaded assets, more behind the loading
+// screen where there is nothing else to do
+#define ASSET_UPLOAD_BUDGET_NS 2000000
+#define LOADING_UPLOAD_BUDGET_NS 12000000
+
+unsigned int read_input();
+void profile_overlay_draw();
+void audio_trace(void *buffer, unsigned int frames);
+void raylib_log(int logLevel, const char *text, va_list args);
+AssetState loading_screen(AssetLoader *loader, AssetHandle handle);
+void sfx_play_events(const GameSession *session);
+bool game_key_pressed(void);
+
+// images and sounds baked by assetPack; without it they load file by file
+AssetPack assets;
+Atlas atlas;
+// sand and rock, which never change, drawn once at startup
+RenderTexture2D groundLayer;
+// rlgl's batch, owned here so the profiler can count what a frame submits
+rlRenderBatch renderBatch;
+int frameDrawCalls;
+int frameVertices;
+// every sprite of a frame, drawn in layer and texture order by one flush
+SpriteQueue spriteQueue;
+Sfx sfx;
+// --latency, only in a GAME_FRAME_CONTROL build
+LatencyMeter latency;
+bool latencyEnabled = false;
+// frame_end's target frame time, 0 for uncapped
+uint64_t frameTargetNs = 0;
+// --late-latch, only in a GAME_FRAME_CONTROL build
+FramePacer pacer;
+bool lateLatch = false;
+
+// Queue a whole sprite sheet
+static void sprite_draw(SpriteLayer layer, int sprite, int x, int y) {
+  Rectangle source = {0, 0, atlas.sprites[sprite].width,
+                      atlas.sprites[sprite].height};
+  atlas_queue(&atlas, &spriteQueue, layer, sprite, source, (Vector2){x, y});
+}
 
-typedef struct {
-  int x;
-  int y;
-  int dy;
-  int dx;
-  Texture2D image;
-  int w;
-  int h;
-  int frameWidth;
-  int frameHeight;
-  unsigned int numberOfFrames;
-  unsigned int frameNumber;
-  int health;
-  ParticleType type;
-  bool isAlive;
-} Particle;
+// Queue a rectangle filled from the atlas' white pixel
+static void rectangle_draw(SpriteLayer layer, Rectangle dest, Color color) {
+  sprite_queue_push(&spriteQueue, layer, atlas.texture, atlas.white, dest,
+                    color);
+}
 
-typedef struct {
-  Particle particles[MAX_PARTICLES];
-  int speed;
-  int count;
-} ParticleSystem;
-
-Particle powerupParticles[6];
-Particle enemyParticles[5];
-Particle bossParticles[3];
-
-void particle_init();
-void particle_free();
-ParticleSystem *particle_system_init(int speed);
-void particle_system_free(ParticleSystem *system);
-void particle_draw(Particle *particle);
-void particle_draw_system(ParticleSystem *system);
-void particle_update_system(ParticleSystem *system);
-void particle_update(Particle *particle);
-void particle_create(Particle *particle);
-void particle_animate(Particle *particle, unsigned long frameCount);
-void particle_update_animation(ParticleSystem *system, unsigned long count);
-
-void particle_boss_system_create_particle(ParticleSystem *system,
-                                          int particleType, int x);
-void particle_power_system_create_particle(ParticleSystem *system,
-                                           int particleType, int x);
-void particle_enemy_system_create_particle(ParticleSystem *system,
-                                           int particleType, int x);
-void particle_create_boss(Particle *particle, int particleType, int x);
-void particle_create_powerup(Particle *particle, int particleType, int x);
-void particle_create_enemy(Particle *particle, int particleType, int x);
-void particle_queue_pattern(ParticleSystem *powerup, ParticleSystem *enemy,
-                            ParticleSystem *boss, unsigned long frameCount);
-int interval(unsigned long frameCount, const int fps);
-void parse_input(double *shark_acceleration);
-void draw_character(unsigned long frameCount);
-void healthBar(int health);
-void particle_spawn_projectiles(ParticleSystem *system,
-                                unsigned long frameCount);
-void player_particle_collision(ParticleSystem *powerup, ParticleSystem *enemy,
-                               ParticleSystem *boss);
-void player_projectile_collision(ParticleSystem *projectiles,
-                                 ParticleSystem *powerup, ParticleSystem *enemy,
-                                 ParticleSystem *boss);
-
-void background(unsigned long frameCount);
-void powerup_particle_update_animation(ParticleSystem *system,
-                                       unsigned long count);
-void powerup_particle_draw_system(ParticleSystem *system);
-
-Texture2D sand;
-Texture2D tiki;
-Texture2D palm;
-Texture2D rock;
-Particle shark;
-Particle shark_projectile;
-double projectile_interval = 1.0; // in seconds
-int num_shark_projectiles = 0;
-double shark_acceleration = 0;
-unsigned long score = 0;
-Texture2D hearts;
-Texture2D half;
-Texture2D empty;
-
-int main() {
+int main(int argc, char **argv) {
+  int renderFps = TICK_RATE;
+  const char *recordPath = NULL;
+  const char *replayPath = NULL;
+  const char *tracePath = NULL;
+  const char *stressPath = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+      // 0 leaves the frame rate uncapped
+      renderFps = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      recordPath = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else if (strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+      // CSV goes to the file, or to stdout for "-"
+      stressPath = argv[++i];
+    } else if (strcmp(argv[i], "--latency") == 0) {
+#if defined(GAME_FRAME_CONTROL)
+      latencyEnabled = true;
+      latency_init(&latency);
+#else
+      fprintf(stderr, "--latency needs a build with GAME_FRAME_CONTROL on\n");
+#endif
+    } else if (strcmp(argv[i], "--late-latch") == 0) {
+#if defined(GAME_FRAME_CONTROL)
+      lateLatch = true;
+#else
+      fprintf(stderr,
+              "--late-latch needs a build with GAME_FRAME_CONTROL on\n");
+#endif
+    }
+  }
+
+  // a replay brings its own seed and replaces the keyboard
+  Replay replay;
+  unsigned int seed = (unsigned int)time(NULL);
+  if (replayPath != NULL) {
+    if (!replay_load(&replay, replayPath)) {
+      return 1;
+    }
+    seed = replay.seed;
+  } else if (recordPath != NULL) {
+    replay_init(&replay, seed, REPLAY_DEFAULT_INTERVAL);
+  }
+  bool inSync = true;
+  bool replayDone = false;
+
+  log_start();
+  SetTraceLogCallback(raylib_log);
+  if (!game_init()) {
+    log_stop();
+    return 1;
+  }
+  if (tracePath != NULL && trace_open(tracePath)) {
+    trace_thread_name("main");
+  }
   InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Sandy Shore Tech Demo 4");
   InitAudioDevice();
-  SetTargetFPS(60);
-  particle_init();
-  ParticleSystem *enemies = particle_system_init(20);
-  ParticleSystem *bosses = particle_system_init(5);
-  ParticleSystem *powerups = particle_system_init(10);
-  ParticleSystem *character_projectiles = particle_system_init(1);
-  unsigned long count = 0;
-  Music bgMusic = LoadMusicStream("../src/assets/sounds/background_music.mp3");
-  PlayMusicStream(bgMusic);
-  SetMusicVolume(bgMusic, 0.5f);
-
-  while (!WindowShouldClose()) {
+  frame_target(renderFps);
+  asset_pack_open(&assets, ASSET_PACK_PATH);
+  sprite_queue_init(&spriteQueue, 4096);
+  AssetLoader loader;
+  asset_loader_start(&loader);
+  AssetHandle atlasLoad = particle_textures_queue(&loader);
+  // the music starts whenever it is ready, the game does not wait for it
+  GameMusic bgMusic;
+  AssetHandle musicLoad = music_queue(&bgMusic, &loader, &assets);
+  sfx_init(&sfx);
+  sfx_queue(&sfx, &loader, &assets);
+  AssetState atlasState = loading_screen(&loader, atlasLoad);
+  if (atlasState != ASSET_LOADED) {
+    asset_loader_stop(&loader);
+    if (asset_loader_state(&loader, atlasLoad) == ASSET_LOADED) {
+      particle_textures_free();
+    }
+    music_free(&bgMusic);
+    sfx_free(&sfx);
+    sprite_queue_free(&spriteQueue);
+    asset_pack_close(&assets);
+    CloseWindow();
+    log_stop();
+    // closing the window while loading is not an error
+    return atlasState == ASSET_FAILED;
+  }
+  background_load();
+  renderBatch = rlLoadRenderBatch(RL_DEFAULT_BATCH_BUFFERS,
+                                  RL_DEFAULT_BATCH_BUFFER_ELEMENTS);
+  rlSetRenderBatchActive(&renderBatch);
+  if (stressPath != NULL) {
+    // nothing may load in the middle of a measured frame
+    asset_loader_finish(&loader);
+    asset_loader_stop(&loader);
+    music_free(&bgMusic);
+    sfx_free(&sfx);
+    frame_target(0);
+    int result = stress_run(strcmp(stressPath, "-") == 0 ? NULL : stressPath);
+    rlSetRenderBatchActive(NULL);
+    rlUnloadRenderBatch(renderBatch);
+    background_free();
+    particle_textures_free();
+    sprite_queue_free(&spriteQueue);
+    asset_pack_close(&assets);
+    CloseWindow();
+    log_stop();
+    return result;
+  }
+  GameSession *session = game_session_create(seed);
+  const double tickTime = 1.0 / TICK_RATE;
+  double accumulator = 0;
+  bool musicPlaying = false;
+  if (trace_enabled()) {
+    AttachAudioMixedProcessor(audio_trace);
+  }
+
+  unsigned char *checkpoint = NULL;
+  size_t checkpointSize = 0;
+  uint64_t frameStart = profile_now_ns();
+  while (!WindowShouldClose() && !game_over(session) && !replayDone) {
+    frame_begin();
+    uint64_t now = profile_now_ns();
+    profile_frame_end(now - frameStart);
+#if defined(GAME_FRAME_CONTROL)
+    // raylib only keeps frame time when its EndDrawing does the swap
+    double frameTime = (now - frameStart) / 1e9;
+#else
+    double frameTime = GetFrameTime();
+#endif
+    frameStart = now;
+    if (IsKeyPressed(KEY_F3)) {
+      profileEnabled = !profileEnabled;
+      profile_reset();
+    }
+    if (IsKeyPressed(KEY_F4)) {
+      trace_flush();
+    }
+    // F5 keeps a checkpoint of the game, F9 goes back to it. Replays are
+    // tied to their own timeline, so they cannot be rewound.
+    if (IsKeyPressed(KEY_F5)) {
+      checkpointSize = snapshot_size(session);
+      checkpoint = realloc(checkpoint, checkpointSize);
+      snapshot_save(session, checkpoint, checkpointSize);
+    }
+    if (IsKeyPressed(KEY_F9) && checkpoint != NULL && replayPath == NULL &&
+        recordPath == NULL) {
+      snapshot_restore(session, checkpoint, checkpointSize);
+    }
     if (IsCursorOnScreen()) {
       DisableCursor();
     }
 
-    count++;
-    if (count % 20 == 0) {
-      score++;
+    uint64_t zone = profile_begin();
+    asset_loader_upload(&loader, ASSET_UPLOAD_BUDGET_NS);
+    profile_end(PROFILE_ASSETS, zone);
+    if (!musicPlaying &&
+        asset_loader_state(&loader, musicLoad) == ASSET_LOADED) {
+      music_play(&bgMusic, 0.5f);
+      musicPlaying = true;
     }
-    particle_queue_pattern(powerups, enemies, bosses, count);
-
-    particle_update_system(enemies);
-    particle_update_animation(enemies, count);
-
-    particle_update_system(bosses);
-    particle_update_animation(bosses, count);
-
-    particle_update_system(powerups);
-    powerup_particle_update_animation(powerups, count);
-
-    particle_spawn_projectiles(character_projectiles, count);
-    particle_update_system(character_projectiles);
 
-    parse_input(&shark_acceleration);
-    player_particle_collision(powerups, enemies, bosses);
-    player_projectile_collision(character_projectiles, powerups, enemies,
-                                bosses);
+    accumulator += frameTime;
+    if (accumulator > MAX_TICKS_PER_FRAME * tickTime) {
+      accumulator = MAX_TICKS_PER_FRAME * tickTime;
+    }
+    zone = profile_begin();
+    while (accumulator >= tickTime) {
+      if (replayPath != NULL) {
+        if (replay_finished(&replay, session)) {
+          replayDone = true;
+          break;
+        }
+        simulation_tick(session, replay_input(&replay, session));
+        sfx_play_events(session);
+        if (inSync && !replay_verify(&replay, session)) {
+          game_log(GAME_LOG_WARNING, "REPLAY: Diverged at tick %lu\n",
+                   session->tick);
+          inSync = false;
+        }
+      } else {
+        unsigned int input = read_input();
+        simulation_tick(session, input);
+        sfx_play_events(session);
+        if (latencyEnabled) {
+          latency_consumed(&latency);
+        }
+        if (recordPath != NULL) {
+          replay_record(&replay, session, input);
+        }
+      }
+      accumulator -= tickTime;
+    }
+    profile_end(PROFILE_SIMULATION, zone);
+    // how far the next tick is, used to interpolate draw positions
+    float alpha = accumulator / tickTime;
 
-    UpdateMusicStream(bgMusic);
+    zone = profile_begin();
+    if (musicPlaying) {
+      music_update(&bgMusic);
+    }
+    profile_end(PROFILE_MUSIC, zone);
 
+    zone = profile_begin();
     BeginDrawing();
     ClearBackground(RAYWHITE);
-    background(count);
-    particle_draw_system(enemies);
-    particle_draw_system(bosses);
-    powerup_particle_draw_system(powerups);
-    particle_draw_system(character_projectiles);
-    healthBar(shark.health);
-    DrawRectangle(SCREEN_WIDTH - ((int)log10(score)) * 10 - 110, 0,
-                  SCREEN_WIDTH, 40, WHITE);
+    background(session->tick);
+    particle_draw_system(&session->enemies, session->tick, alpha);
+    particle_draw_system(&session->bosses, session->tick, alpha);
+    powerup_particle_draw_system(&session->powerups, session->tick, alpha);
+    particle_draw_system(&session->projectiles, session->tick, alpha);
+    bullet_draw_pool(&session->bullets, alpha);
+    draw_character(&session->shark, session->tick, alpha);
+    healthBar(session->shark.health);
+    unsigned long score = session->score;
+    rectangle_draw(SPRITE_LAYER_HUD,
+                   (Rectangle){SCREEN_WIDTH - ((int)log10(score)) * 10 - 110,
+                               0, SCREEN_WIDTH, 40},
+                   WHITE);
+    // the score text needs the font texture, so it is drawn straight after
+    // the queue to cost only one more draw call
+    sprite_queue_flush(&spriteQueue);
     DrawText(TextFormat("Score: %d", score),
              SCREEN_WIDTH - ((int)log10(score)) * 10 + 10 - 110, 10, 20, BLACK);
-    // draw player
-    // call the function to draw the score and lives
-    draw_character(count);
-    EndDrawing();
+    if (profileEnabled) {
+      profile_overlay_draw();
+      // what is still queued is everything EndDrawing is about to submit
+      frameDrawCalls = 0;
+      frameVertices = 0;
+      for (int i = 0; i < renderBatch.drawCounter; i++) {
+        if (renderBatch.draws[i].vertexCount > 0) {
+          frameDrawCalls++;
+          frameVertices += renderBatch.draws[i].vertexCount;
+        }
+      }
+    }
+    profile_end(PROFILE_DRAW, zone);
+
+    // submit the batch here so the GPU upload is timed apart from the swap
+    zone = profile_begin();
+    rlDrawRenderBatchActive();
+    profile_end(PROFILE_BATCH, zone);
+
+    zone = profile_begin();
+    frame_end();
+    profile_end(PROFILE_PRESENT, zone);
   }
 
-  UnloadMusicStream(bgMusic);
+  if (replayPath == NULL && recordPath != NULL) {
+    replay_save(&replay, session, recordPath);
+  }
+  if (replayPath != NULL || recordPath != NULL) {
+    replay_free(&replay);
+  }
+  if (trace_enabled()) {
+    DetachAudioMixedProcessor(audio_trace);
+  }
+  if (latencyEnabled) {
+    latency_report(&latency, stdout);
+  }
+  asset_loader_stop(&loader);
+  music_free(&bgMusic);
+  sfx_free(&sfx);
+  rlSetRenderBatchActive(NULL);
+  rlUnloadRenderBatch(renderBatch);
+  background_free();
+  particle_textures_free();
+  sprite_queue_free(&spriteQueue);
+  asset_pack_close(&assets);
   CloseWindow();
-  particle_system_free(enemies);
-  particle_system_free(powerups);
-  particle_system_free(bosses);
-  particle_system_free(character_projectiles);
-  particle_free();
+  game_session_free(session);
+  free(checkpoint);
+  trace_close();
+  log_stop();
 
   return 0;
 }
 
-void parse_input(double *acceleration) {
-  int lastKey = GetKeyPressed();
-  bool left = IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT);
-  bool right = IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT);
-  if (right && shark.x + 1 + (20 * *acceleration) < 482 && !left) {
-    if (*acceleration < 0) {
-      *acceleration = 0;
-    }
-    shark.x += 1 + (20 * *acceleration);
-    *acceleration += 0.005;
-  } else if (left && shark.x + -1 + (20 * *acceleration) > 130 && !right) {
-    if (*acceleration > 0) {
-      *acceleration = 0;
-    }
-    shark.x += -1 + (20 * *acceleration);
-    *acceleration -= 0.005;
-  } else {
-    *acceleration = 0;
-  }
+void frame_target(int fps) {
+  SetTargetFPS(fps);
+  frameTargetNs = fps > 0 ? 1000000000 / fps : 0;
+  pacer_init(&pacer, frameTargetNs);
 }
 
-void draw_character(unsigned long frameCount) {
-  if (frameCount % 15 == 0) {
-    shark.frameNumber += 1;
+#if defined(GAME_FRAME_CONTROL)
+static void frame_poll(void) {
+  PollInputEvents();
+  if (latencyEnabled && game_key_pressed()) {
+    latency_input(&latency, profile_now_ns());
   }
-  int frame = shark.frameNumber % shark.numberOfFrames;
-  Rectangle source = {frame * shark.frameWidth, 0, shark.frameWidth,
-                      shark.frameHeight};
-  Vector2 position = {shark.x, shark.y};
-  DrawTextureRec(shark.image, source, position, WHITE);
 }
-
-ParticleSystem *particle_system_init(int speed) {
-  ParticleSystem *system = MemAlloc(sizeof(ParticleSystem));
-  system->speed = speed;
-  system->count = 0;
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    system->particles[i].isAlive = false;
+#endif
+
+// With --late-latch the wait and the poll move here from the end of the
+// last frame: sleep until the frame's work, as long as it has lately taken,
+// would end right on the next swap, then read the input it will show.
+void frame_begin(void) {
+#if defined(GAME_FRAME_CONTROL)
+  if (!lateLatch) {
+    return;
   }
-  return system;
-}
-
-void particle_spawn_projectiles(ParticleSystem *system,
-                                unsigned long frameCount) {
-  if (frameCount % (int)(projectile_interval * 60) == 0) {
-    int index = 0;
-    while (index < MAX_PARTICLES) {
-      if (!system->particles[index].isAlive) {
-        break;
-      }
-      index++;
+  if (frameTargetNs > 0) {
+    uint64_t now = profile_now_ns();
+    uint64_t wake = pacer_wake(&pacer, now);
+    if (wake > now) {
+      WaitTime((wake - now) / 1e9);
     }
-    Particle *projectile = &system->particles[index];
-    memcpy(projectile, &shark_projectile, sizeof(Particle));
-    projectile->x =
-        shark.x + (shark.frameWidth / 2 - projectile->frameWidth / 2);
-    projectile->y = shark.y - shark_projectile.frameHeight;
   }
+  frame_poll();
+  pacer_work_start(&pacer, profile_now_ns());
+#endif
 }
 
-void particle_system_free(ParticleSystem *system) { MemFree(system); }
-
-void particle_draw(Particle *particle) {
-  int frame = particle->frameNumber % particle->numberOfFrames;
-  Rectangle source = {frame * particle->frameWidth, 0, particle->frameWidth,
-                      particle->frameHeight};
-  Vector2 position = {particle->x, particle->y};
-  DrawTextureRec(particle->image, source, position, WHITE);
-}
-
-void particle_draw_system(ParticleSystem *system) {
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    if (system->particles[i].isAlive) {
-      particle_draw(&system->particles[i]);
-    }
+// With GAME_FRAME_CONTROL raylib's EndDrawing stops after submitting the
+// batch, and the swap, the wait for the target frame time and the input poll
+// happen here, in the same order, where they can be timed. With --late-latch
+// only the swap does; frame_begin waits and polls.
+void frame_end(void) {
+  EndDrawing();
+#if defined(GAME_FRAME_CONTROL)
+  static uint64_t lastWait = 0;
+  if (lateLatch) {
+    pacer_work_end(&pacer, profile_now_ns());
+  }
+  SwapScreenBuffer();
+  uint64_t now = profile_now_ns();
+  if (latencyEnabled) {
+    latency_presented(&latency, now);
+  }
+  if (lateLatch) {
+    return;
   }
-}
-
-void powerup_particle_draw_system(ParticleSystem *system) {
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    if (system->particles[i].isAlive) {
-      // printf("DRAW POWER UP FOR TYPE %d\n", system->particles[i].type);
-      if ((system->particles[i].type & BOX) == BOX) {
-        if (system->particles[i].health >= 2) {
-          printf("DRAW BOX\n");
-          powerupParticles[0].frameNumber = 0;
-          powerupParticles[0].x = system->particles[i].x;
-          powerupParticles[0].y = system->particles[i].y;
-          particle_draw(&powerupParticles[0]);
-        } else if (system->particles[i].health == 1) {
-          printf("DRAW BROKEN BOX\n");
-          powerupParticles[0].frameNumber = 1;
-          powerupParticles[0].x = system->particles[i].x;
-          powerupParticles[0].y = system->particles[i].y;
-          particle_draw(&powerupParticles[0]);
-        }
-      } else {
-        //	    printf("DRAW POWERUP\n");
-        particle_draw(&system->particles[i]);
-      }
-    }
+  if (now - lastWait < frameTargetNs) {
+    WaitTime((frameTargetNs - (now - lastWait)) / 1e9);
   }
+  lastWait = profile_now_ns();
+  frame_poll();
+#endif
 }
 
-void particle_update_system(ParticleSystem *system) {
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    particle_update(&system->particles[i]);
-  }
+// A key read_input cares about went down in the last poll
+bool game_key_pressed(void) {
+  return IsKeyPressed(KEY_A) || IsKeyPressed(KEY_LEFT) ||
+         IsKeyPressed(KEY_D) || IsKeyPressed(KEY_RIGHT);
 }
 
-void particle_update(Particle *particle) {
-  if (particle->isAlive) {
-    if (particle->health <= 0 && (particle->type < 1 || particle->type > 48)) {
-      particle->isAlive = false;
-    }
-
-    if (particle->y > SCREEN_HEIGHT + particle->h) {
-      particle->isAlive = false;
-    } else if (particle->type == PROJECTILE &&
-               particle->y + particle->frameHeight < 0) {
-      particle->isAlive = false;
-    } else {
-      particle->y += particle->dy;
-    }
+unsigned int read_input() {
+  unsigned int input = 0;
+  if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) {
+    input |= INPUT_LEFT;
   }
+  if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) {
+    input |= INPUT_RIGHT;
+  }
+  return input;
 }
 
-void particle_create_enemy(Particle *particle, int particleType, int x) {
-  memcpy(particle, &enemyParticles[particleType], sizeof(Particle));
-  particle->x = x;
-  particle->y = -particle->frameHeight;
-  particle->isAlive = true;
-}
-
-void particle_create_powerup(Particle *particle, int particleType, int x) {
-  memcpy(particle, &powerupParticles[particleType], sizeof(Particle));
-  particle->x = x;
-  particle->y = -particle->frameHeight;
-  particle->isAlive = true;
+// The shark's animation starts with the game, at tick 0
+void draw_character(const Player *shark, unsigned long tick, float alpha) {
+  const Archetype *a = &archetypes[ARCHETYPE_SHARK];
+  int x = shark->prevX + (int)roundf((shark->x - shark->prevX) * alpha);
+  particle_draw(SPRITE_LAYER_CHARACTER, ARCHETYPE_SHARK,
+                archetype_frame(a, tick, 0), x, shark->y);
 }
 
-void particle_create_boss(Particle *particle, int particleType, int x) {
-  memcpy(particle, &bossParticles[particleType], sizeof(Particle));
-  particle->x = x;
-  particle->y = -particle->frameHeight;
-  particle->isAlive = true;
+// The baked atlas when there is an asset pack, else the sprite sheets packed
+// on the spot. Either way the pixels are ready before the main thread sees
+// them, and the upload is one texture.
+typedef struct {
+  Image pixels;
+  bool baked;
+} AtlasLoad;
+
+static bool atlas_load_decode(void *user) {
+  AtlasLoad *load = user;
+  load->baked = atlas_read_pack(&atlas, &load->pixels, &assets);
+  return load->baked ||
+         atlas_pack(&atlas, &load->pixels, ASSET_SOURCE_DIR, spriteImages,
+                    SPRITE_COUNT);
 }
 
-void particle_enemy_system_create_particle(ParticleSystem *system,
-                                           int particleType, int x) {
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    if (!system->particles[i].isAlive) {
-      particle_create_enemy(&system->particles[i], particleType, x);
-      return;
-    }
+static bool atlas_load_upload(void *user, bool decoded) {
+  AtlasLoad *load = user;
+  if (!decoded) {
+    return false;
   }
-}
-
-void particle_power_system_create_particle(ParticleSystem *system,
-                                           int particleType, int x) {
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    if (!system->particles[i].isAlive) {
-      particle_create_powerup(&system->particles[i], particleType, x);
-      return;
-    }
+  atlas_upload(&atlas, load->pixels);
+  if (!load->baked) {
+    UnloadImage(load->pixels);
   }
+  // rectangles sample the atlas' white pixel and join the sprite batch
+  SetShapesTexture(atlas.texture, atlas.white);
+  return true;
 }
 
-void particle_boss_system_create_particle(ParticleSystem *system,
-                                          int particleType, int x) {
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    if (!system->particles[i].isAlive) {
-      particle_create_boss(&system->particles[i], particleType, x);
-      return;
-    }
-  }
+AssetHandle particle_textures_queue(AssetLoader *loader) {
+  static AtlasLoad load;
+  return asset_loader_add(loader, "atlas", atlas_load_decode,
+                          atlas_load_upload, &load);
 }
 
-void particle_init() {
-  powerupParticles[0].dx = 0;
-  powerupParticles[0].dy = 1;
-  powerupParticles[0].image = LoadTexture("../src/assets/images/crate.png");
-  powerupParticles[0].w = 48;
-  powerupParticles[0].h = 25;
-  powerupParticles[0].frameWidth = 24;
-  powerupParticles[0].frameHeight = 25;
-  powerupParticles[0].numberOfFrames = 2;
-  powerupParticles[0].frameNumber = 0;
-  powerupParticles[0].health = 2;
-  powerupParticles[0].type = BOX;
-  powerupParticles[0].isAlive = true;
-
-  powerupParticles[1].dx = 0;
-  powerupParticles[1].dy = 1;
-  powerupParticles[1].image =
-      LoadTexture("../src/assets/images/cake_slice.png");
-  powerupParticles[1].w = 60;
-  powerupParticles[1].h = 28;
-  powerupParticles[1].frameWidth = 30;
-  powerupParticles[1].frameHeight = 28;
-  powerupParticles[1].numberOfFrames = 2;
-  powerupParticles[1].frameNumber = 0;
-  powerupParticles[1].health = 2;
-  powerupParticles[1].type = POWER_UP_HEALTH | BOX;
-  powerupParticles[1].isAlive = true;
-
-  powerupParticles[2].dx = 0;
-  powerupParticles[2].dy = 1;
-  powerupParticles[2].image = LoadTexture("../src/assets/images/coconut.png");
-  powerupParticles[2].w = 102;
-  powerupParticles[2].h = 40;
-  powerupParticles[2].frameWidth = 102 / 3;
-  powerupParticles[2].frameHeight = 40;
-  powerupParticles[2].numberOfFrames = 3;
-  powerupParticles[2].frameNumber = 0;
-  powerupParticles[2].health = 2;
-  powerupParticles[2].type = POWER_UP_INVIS | BOX;
-  powerupParticles[2].isAlive = true;
-
-  powerupParticles[3].dx = 0;
-  powerupParticles[3].dy = 1;
-  powerupParticles[3].image = LoadTexture("../src/assets/images/mango.png");
-  powerupParticles[3].w = 175;
-  powerupParticles[3].h = 27;
-  powerupParticles[3].frameWidth = 175 / 7;
-  powerupParticles[3].frameHeight = 27;
-  powerupParticles[3].numberOfFrames = 7;
-  powerupParticles[3].frameNumber = 0;
-  powerupParticles[3].health = 2;
-  powerupParticles[3].type = POWER_UP_DOUBLE_FIRE_DAMAGE | BOX;
-  powerupParticles[3].isAlive = true;
-
-  powerupParticles[4].dx = 0;
-  powerupParticles[4].dy = 1;
-  powerupParticles[4].image = LoadTexture("../src/assets/images/soda.png");
-  powerupParticles[4].w = 200;
-  powerupParticles[4].h = 50;
-  powerupParticles[4].frameWidth = 200 / 4;
-  powerupParticles[4].frameHeight = 50;
-  powerupParticles[4].numberOfFrames = 4;
-  powerupParticles[4].frameNumber = 0;
-  powerupParticles[4].health = 2;
-  powerupParticles[4].type = POWER_UP_DOUBLE_ENEMY_DAMAGE | BOX;
-  powerupParticles[4].isAlive = true;
-
-  powerupParticles[5].dx = 0;
-  powerupParticles[5].dy = 1;
-  powerupParticles[5].image = LoadTexture("../src/assets/images/tea.png");
-  powerupParticles[5].w = 39;
-  powerupParticles[5].h = 21;
-  powerupParticles[5].frameWidth = 39 / 3;
-  powerupParticles[5].frameHeight = 21;
-  powerupParticles[5].numberOfFrames = 3;
-  powerupParticles[5].frameNumber = 0;
-  powerupParticles[5].health = 2;
-  powerupParticles[5].type = POWER_UP_SPREAD | BOX;
-  powerupParticles[5].isAlive = true;
-
-  enemyParticles[0].dx = 0;
-  enemyParticles[0].dy = 1;
-  enemyParticles[0].image = LoadTexture("../src/assets/images/straw.png");
-  enemyParticles[0].w = 124;
-  enemyParticles[0].h = 30;
-  enemyParticles[0].frameWidth = 124 / 4;
-  enemyParticles[0].frameHeight = 30;
-  enemyParticles[0].numberOfFrames = 4;
-  enemyParticles[0].frameNumber = 0;
-  enemyParticles[0].health = 1;
-  enemyParticles[0].type = ENEMY;
-  enemyParticles[0].isAlive = true;
-
-  enemyParticles[1].dx = 0;
-  enemyParticles[1].dy = 1;
-  enemyParticles[1].image = LoadTexture("../src/assets/images/rings.png");
-  enemyParticles[1].w = 64;
-  enemyParticles[1].h = 32;
-  enemyParticles[1].frameWidth = 32;
-  enemyParticles[1].frameHeight = 32;
-  enemyParticles[1].numberOfFrames = 2;
-  enemyParticles[1].frameNumber = 0;
-  enemyParticles[1].health = 2;
-  enemyParticles[1].type = ENEMY;
-  enemyParticles[1].isAlive = true;
-
-  enemyParticles[2].dx = 0;
-  enemyParticles[2].dy = 1;
-  enemyParticles[2].image = LoadTexture("../src/assets/images/anchor.png");
-  enemyParticles[2].w = 48;
-  enemyParticles[2].h = 24;
-  enemyParticles[2].frameWidth = 24;
-  enemyParticles[2].frameHeight = 24;
-  enemyParticles[2].numberOfFrames = 2;
-  enemyParticles[2].frameNumber = 0;
-  enemyParticles[2].health = 3;
-  enemyParticles[2].type = ENEMY;
-  enemyParticles[2].isAlive = true;
-
-  enemyParticles[3].dx = 0;
-  enemyParticles[3].dy = 1;
-  enemyParticles[3].image = LoadTexture("../src/assets/images/jellyfish.png");
-  enemyParticles[3].w = 96;
-  enemyParticles[3].h = 32;
-  enemyParticles[3].frameWidth = 32;
-  enemyParticles[3].frameHeight = 32;
-  enemyParticles[3].numberOfFrames = 3;
-  enemyParticles[3].frameNumber = 0;
-  enemyParticles[3].health = 3;
-  enemyParticles[3].type = ENEMY;
-  enemyParticles[3].isAlive = true;
-
-  enemyParticles[4].dx = 0;
-  enemyParticles[4].dy = 1;
-  enemyParticles[4].image = LoadTexture("../src/assets/images/oilspill.png");
-  enemyParticles[4].w = 40;
-  enemyParticles[4].h = 17;
-  enemyParticles[4].frameWidth = 20;
-  enemyParticles[4].frameHeight = 17;
-  enemyParticles[4].numberOfFrames = 2;
-  enemyParticles[4].frameNumber = 0;
-  enemyParticles[4].health = 32768;
-  enemyParticles[4].type = ENEMY;
-  enemyParticles[4].isAlive = true;
-
-  bossParticles[0].dx = 0;
-  bossParticles[0].dy = 1;
-  bossParticles[0].image = LoadTexture("../src/assets/images/orca.png");
-  bossParticles[0].w = 200;
-  bossParticles[0].h = 56;
-  bossParticles[0].frameWidth = 100;
-  bossParticles[0].frameHeight = 56;
-  bossParticles[0].numberOfFrames = 2;
-  bossParticles[0].frameNumber = 0;
-  bossParticles[0].health = 8;
-  bossParticles[0].type = ENEMY;
-  bossParticles[0].isAlive = true;
-
-  bossParticles[1].dx = 0;
-  bossParticles[1].dy = 1;
-  bossParticles[1].image = LoadTexture("../src/assets/images/eel.png");
-  bossParticles[1].w = 320;
-  bossParticles[1].h = 64;
-  bossParticles[1].frameWidth = 320 / 5;
-  bossParticles[1].frameHeight = 64;
-  bossParticles[1].numberOfFrames = 5;
-  bossParticles[1].frameNumber = 0;
-  bossParticles[1].health = 10;
-  bossParticles[1].type = ENEMY;
-  bossParticles[1].isAlive = true;
-
-  bossParticles[2].dx = 0;
-  bossParticles[2].dy = 1;
-  bossParticles[2].image = LoadTexture("../src/assets/images/kraken.png");
-  bossParticles[2].w = 192;
-  bossParticles[2].h = 58;
-  bossParticles[2].frameWidth = 192 / 3;
-  bossParticles[2].frameHeight = 58;
-  bossParticles[2].numberOfFrames = 3;
-  bossParticles[2].frameNumber = 0;
-  bossParticles[2].health = 12;
-  bossParticles[2].type = ENEMY;
-  bossParticles[2].isAlive = true;
-
-  sand = LoadTexture("../src/assets/images/sand.png");
-  tiki = LoadTexture("../src/assets/images/tiki.png");
-  palm = LoadTexture("../src/assets/images/palmtree.png");
-  rock = LoadTexture("../src/assets/images/rock.png");
-  shark.image = LoadTexture("../src/assets/images/shark.png");
-  shark.isAlive = true;
-  shark.frameNumber = 0;
-  shark.frameWidth = 30;
-  shark.frameHeight = 80;
-  shark.x = SCREEN_WIDTH / 2 - shark.frameWidth / 2;
-  shark.y = SCREEN_HEIGHT - shark.frameHeight - 20;
-  shark.numberOfFrames = 4;
-  shark.health = 6;
-
-  shark_projectile.image = LoadTexture("../src/assets/images/harpoon.png");
-  shark_projectile.isAlive = true;
-  shark_projectile.frameWidth = 15;
-  shark_projectile.frameHeight = 39;
-  shark_projectile.frameNumber = 1;
-  shark_projectile.numberOfFrames = 1;
-  shark_projectile.health = 1;
-  shark_projectile.dy = -2;
-  shark_projectile.type = PROJECTILE;
-  hearts = LoadTexture("../src/assets/images/heart1.png");
-  half = LoadTexture("../src/assets/images/heart2.png");
-  empty = LoadTexture("../src/assets/images/heart3.png");
+void particle_textures_free() { atlas_free(&atlas); }
+
+// Hold a progress bar up until handle is loaded, uploading as it goes.
+// Returns its state, still pending if the window was closed first.
+AssetState loading_screen(AssetLoader *loader, AssetHandle handle) {
+  while (!WindowShouldClose() &&
+         asset_loader_state(loader, handle) == ASSET_PENDING) {
+    frame_begin();
+    int pending = asset_loader_upload(loader, LOADING_UPLOAD_BUDGET_NS);
+    int barWidth = SCREEN_WIDTH / 2;
+    int done = barWidth - barWidth * pending / loader->count;
+    BeginDrawing();
+    ClearBackground(BLACK);
+    DrawText("Loading", SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 - 30, 20,
+             RAYWHITE);
+    DrawRectangleLines(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2, barWidth, 10,
+                       RAYWHITE);
+    DrawRectangle(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2, done, 10, RAYWHITE);
+    frame_end();
+  }
+  return asset_loader_state(loader, handle);
 }
 
-void particle_free() {
-  for (int i = 0; i < 6; i++) {
-    UnloadTexture(powerupParticles[i].image);
-  }
-  for (int i = 0; i < 5; i++) {
-    UnloadTexture(enemyParticles[i].image);
-  }
-  for (int i = 0; i < 3; i++) {
-    UnloadTexture(bossParticles[i].image);
+static const SoundId eventSounds[GAME_EVENT_COUNT] = {
+    [GAME_EVENT_FIRE] = SOUND_PROJECTILE,
+    [GAME_EVENT_CRATE_HIT] = SOUND_CRATE,
+    [GAME_EVENT_PICKUP] = SOUND_YUMMY,
+    [GAME_EVENT_HURT] = SOUND_UMBRELLA,
+};
+
+// One sound per kind of event in the tick, however many there were
+void sfx_play_events(const GameSession *session) {
+  for (int e = 0; e < GAME_EVENT_COUNT; e++) {
+    if (session->events[e] > 0) {
+      sfx_trigger(&sfx, eventSounds[e]);
+    }
   }
+  sfx_flush(&sfx);
 }
 
-void particle_animate(Particle *particle, unsigned long frameCount) {
-  if (frameCount % 30 == 0) {
-    particle->frameNumber++;
-  }
+void particle_draw(SpriteLayer layer, int archetype, unsigned int frame, int x,
+                   int y) {
+  const Archetype *a = &archetypes[archetype];
+  Rectangle source = {frame * a->frameWidth, 0, a->frameWidth,
+                      a->frameHeight};
+  Vector2 position = {x, y};
+  atlas_queue(&atlas, &spriteQueue, layer, archetype, source, position);
 }
 
-void particle_update_animation(ParticleSystem *system, unsigned long count) {
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    particle_animate(&system->particles[i], count);
-  }
+// Particles only move by dy each tick, so the position between the previous
+// tick and the current one is y - dy * (1 - alpha).
+static int particle_draw_y(ParticleSystem *system, int i, float alpha) {
+  return system->y[i] - (int)roundf(system->dy[i] * (1.0f - alpha));
 }
 
-void powerup_particle_update_animation(ParticleSystem *system,
-                                       unsigned long count) {
-  Particle *p;
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    p = &system->particles[i];
-    if ((p->type & BOX) == BOX) {
-      if (p->health >= 2) {
-        // Draw unbroken box
-        printf("ANIMATION UPDATE BOX\n");
-        p->frameNumber = 0;
-      } else if (p->health == 1) {
-        // Draw broken box
-        printf("ANIMATION UPDATE BROKEN BOX\n");
-        p->frameNumber = 1;
-      } else {
-        // Remove the box 'property'
-        printf("ANIMATION UPDATE CONVERT TO POWER UP\n");
-        p->type = BOX ^ p->type;
-      }
-    } else {
-      particle_animate(p, count);
-    }
+void particle_draw_system(ParticleSystem *system, unsigned long tick,
+                          float alpha) {
+  for (int k = 0; k < system->count; k++) {
+    int i = system->alive[k];
+    int archetype = system->archetype[i];
+    unsigned int frame =
+        archetype_frame(&archetypes[archetype], tick, system->phase[i]);
+    particle_draw(SPRITE_LAYER_PARTICLES, archetype, frame, system->x[i],
+                  particle_draw_y(system, i, alpha));
   }
 }
 
-unsigned long nextPatternTime = 0;
-unsigned int lastInterval = 0;
-void particle_queue_pattern(ParticleSystem *powerup, ParticleSystem *enemy,
-                            ParticleSystem *boss, unsigned long frameCount) {
-  if (frameCount < nextPatternTime) {
-    return;
-  }
-  // Can I generate a pattern at this time?
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    if (powerup->particles[i].y < 0 && powerup->particles[i].isAlive) {
-      return;
-    }
-    if (enemy->particles[i].y < 0 && enemy->particles[i].isAlive) {
-      return;
-    }
-    if (boss->particles[i].y < 0 && boss->particles[i].isAlive) {
-      return;
-    }
-  }
-  // Do I delay generation?
-  if (lastInterval == interval(frameCount, 60)) {
-    int r = GetRandomValue(0, SINGLE_LINE_PATTERN_COUNT - 1);
-    for (int i = 4; i < 12 + 4; i++) {
-      switch ((int)singleLinePatterns[r][i]) {
-      case ENEMY:
-        int e = GetRandomValue(0, 4);
-        particle_enemy_system_create_particle(enemy, e, i * 32);
-        break;
-      case POWERUP:
-        printf("SPAWNING POWER\n");
-        int f = GetRandomValue(1, 5);
-        particle_power_system_create_particle(powerup, f, i * 32);
-        break;
-      }
-    }
-  } else {
-    int r = GetRandomValue(0, MULTI_LINE_PATTERN_COUNT - 1);
-    for (int j = 0; j < 3; j++) {
-      for (int i = 4; i < 12 + 4; i++) {
-        switch ((int)multipleLinePattern[r][j][i]) {
-        case ENEMY:
-          int e = GetRandomValue(0, 4);
-          particle_enemy_system_create_particle(enemy, e, i * 32);
-          break;
-        case POWERUP:
-          int f = GetRandomValue(1, 5);
-          particle_power_system_create_particle(powerup, f, i * 32);
-          break;
-        case BOSS_ORCA:
-          particle_boss_system_create_particle(boss, 0, i * 32);
-          break;
-        case BOSS_EEL:
-          particle_boss_system_create_particle(boss, 1, i * 32);
-          break;
-        case BOSS_KRAKEN:
-          particle_boss_system_create_particle(boss, 2, i * 32);
-          break;
-        }
+void powerup_particle_draw_system(ParticleSystem *system, unsigned long tick,
+                                  float alpha) {
+  for (int k = 0; k < system->count; k++) {
+    int i = system->alive[k];
+    int y = particle_draw_y(system, i, alpha);
+    // printf("DRAW POWER UP FOR TYPE %d\n", system->type[i]);
+    if ((system->type[i] & BOX) == BOX) {
+      if (system->health[i] >= 2) {
+        game_log(GAME_LOG_DEBUG, "DRAW BOX\n");
+        particle_draw(SPRITE_LAYER_PARTICLES, ARCHETYPE_CRATE, 0, system->x[i],
+                      y);
+      } else if (system->health[i] == 1) {
+        game_log(GAME_LOG_DEBUG, "DRAW BROKEN BOX\n");
+        particle_draw(SPRITE_LAYER_PARTICLES, ARCHETYPE_CRATE, 1, system->x[i],
+                      y);
       }
+    } else {
+      //	    printf("DRAW POWERUP\n");
+      int archetype = system->archetype[i];
+      unsigned int frame =
+          archetype_frame(&archetypes[archetype], tick, system->phase[i]);
+      particle_draw(SPRITE_LAYER_PARTICLES, archetype, frame, system->x[i], y);
     }
   }
-  // Do I generate a single line or multiple pattern
-  // Which patterd do I choose:
-
-  lastInterval = interval(frameCount, 60);
-  nextPatternTime = frameCount + lastInterval * 60;
 }
 
-int interval(unsigned long frameCount, const int fps) {
-  int time = frameCount / fps;
-  if (time < 30) {
-    score++;
-    return 6;
-  } else if (time < 75) {
-    score += 2;
-    return 4;
-  } else if (time < 150) {
-    score += 3;
-    return 2;
-  } else if (time < 240) {
-    score += 4;
-    return 1;
-  } else {
-    score += 5;
-    return 0;
+// Bullets are plain squares from the atlas' white pixel, so ten thousand of
+// them need no texture change of their own. They move in a straight line,
+// so the drawn position steps back from the current one by the unfinished
+// part of the tick.
+void bullet_draw_pool(const BulletPool *pool, float alpha) {
+  const float back = (1.0f - alpha) / (1 << BULLET_SHIFT);
+  for (int i = 0; i < pool->count; i++) {
+    float x = pool->x[i] / (float)(1 << BULLET_SHIFT) - pool->vx[i] * back;
+    float y = pool->y[i] / (float)(1 << BULLET_SHIFT) - pool->vy[i] * back;
+    rectangle_draw(SPRITE_LAYER_BULLETS,
+                   (Rectangle){x - BULLET_RADIUS, y - BULLET_RADIUS,
+                               2 * BULLET_RADIUS, 2 * BULLET_RADIUS},
+                   MAROON);
   }
 }
 
-void background(unsigned long frameCount) {
+void background_load() {
+  TRACE_SCOPE("background_load");
+  groundLayer = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
+  BeginTextureMode(groundLayer);
+  ClearBackground(BLANK);
   // sand
-  for (int i = -32 + frameCount % 32; i < SCREEN_HEIGHT; i += 32) {
+  for (int i = 0; i < SCREEN_HEIGHT; i += 32) {
     for (int j = 0; j < SCREEN_WIDTH; j += 32) {
-      DrawTexture(sand, j, i, WHITE);
+      sprite_draw(SPRITE_LAYER_GROUND, SPRITE_SAND, j, i);
     }
   }
   // rock
-  for (int i = -32 + frameCount % 32; i < SCREEN_HEIGHT; i += 32) {
-    DrawTexture(rock, 32 * 3, i, WHITE);
-    DrawTexture(rock, SCREEN_WIDTH - 32 * 4, i, WHITE);
+  for (int i = 0; i < SCREEN_HEIGHT; i += 32) {
+    sprite_draw(SPRITE_LAYER_GROUND, SPRITE_ROCK, 32 * 3, i);
+    sprite_draw(SPRITE_LAYER_GROUND, SPRITE_ROCK, SCREEN_WIDTH - 32 * 4, i);
   }
+  sprite_queue_flush(&spriteQueue);
+  EndTextureMode();
+}
+
+void background_free() { UnloadRenderTexture(groundLayer); }
+
+void background(unsigned long frameCount) {
+  // The ground layer tiles vertically, so it scrolls as two screen-sized
+  // quads: one at the offset and one wrapped round just above it. Render
+  // textures are stored upside down, hence the negative source height.
+  int offset = frameCount % SCREEN_HEIGHT;
+  Rectangle ground = {0, 0, SCREEN_WIDTH, -SCREEN_HEIGHT};
+  sprite_queue_push(&spriteQueue, SPRITE_LAYER_GROUND, groundLayer.texture,
+                    ground, (Rectangle){0, offset, SCREEN_WIDTH, SCREEN_HEIGHT},
+                    WHITE);
+  sprite_queue_push(&spriteQueue, SPRITE_LAYER_GROUND, groundLayer.texture,
+                    ground,
+                    (Rectangle){0, offset - SCREEN_HEIGHT, SCREEN_WIDTH,
+                                SCREEN_HEIGHT},
+                    WHITE);
 
   // trees
   Rectangle r = {32 * (frameCount / 10 % 5), 0, 32, 64};
@@ -770,9 +623,11 @@ void background(unsigned long frameCount) {
   for (int i = -128 + frameCount % 128; i < SCREEN_HEIGHT; i += 128) {
     p.x = 0;
     p.y = i;
-    DrawTextureRec(palm, r, p, WHITE);
+    atlas_queue(&atlas, &spriteQueue, SPRITE_LAYER_SCENERY, SPRITE_PALM, r,
+                p);
     p.x = SCREEN_WIDTH - 32;
-    DrawTextureRec(palm, r, p, WHITE);
+    atlas_queue(&atlas, &spriteQueue, SPRITE_LAYER_SCENERY, SPRITE_PALM, r,
+                p);
   }
 
   // tiki
@@ -780,123 +635,133 @@ void background(unsigned long frameCount) {
   for (int i = -64 + frameCount % 128; i < SCREEN_HEIGHT; i += 128) {
     p.y = i;
     p.x = 32;
-    DrawTextureRec(tiki, r, p, WHITE);
+    atlas_queue(&atlas, &spriteQueue, SPRITE_LAYER_SCENERY, SPRITE_TIKI, r,
+                p);
     p.x = SCREEN_WIDTH - 32 * 2;
-    DrawTextureRec(tiki, r, p, WHITE);
+    atlas_queue(&atlas, &spriteQueue, SPRITE_LAYER_SCENERY, SPRITE_TIKI, r,
+                p);
   }
   r.x = 32 * (frameCount / 5 % 5);
   for (int i = -128 + frameCount % 128; i < SCREEN_HEIGHT; i += 128) {
     p.x = 32 * 2;
     p.y = i;
-    DrawTextureRec(tiki, r, p, WHITE);
+    atlas_queue(&atlas, &spriteQueue, SPRITE_LAYER_SCENERY, SPRITE_TIKI, r,
+                p);
     p.x = SCREEN_WIDTH - 32 * 3;
-    DrawTextureRec(tiki, r, p, WHITE);
+    atlas_queue(&atlas, &spriteQueue, SPRITE_LAYER_SCENERY, SPRITE_TIKI, r,
+                p);
   }
 }
 
 void healthBar(int health) {
   // 3 hearts with half hearts
   // draw hearts
-  if (health <= 0) {
-    CloseWindow();
-  }
   int lost = 6 - health;
   if (health % 2 == 0) {
     for (int i = 0; i < health / 2; i++) {
-      DrawTexture(hearts, (i * 32) + 10, 0, WHITE);
+      sprite_draw(SPRITE_LAYER_HUD, SPRITE_HEART, (i * 32) + 10, 0);
     }
   } else {
     for (int i = 0; i < health / 2; i++) {
-      DrawTexture(hearts, (i * 32) + 10, 0, WHITE);
+      sprite_draw(SPRITE_LAYER_HUD, SPRITE_HEART, (i * 32) + 10, 0);
     }
-    DrawTexture(half, (health / 2) * 32 + 10, 0, WHITE);
+    sprite_draw(SPRITE_LAYER_HUD, SPRITE_HEART_HALF, (health / 2) * 32 + 10, 0);
   }
 
   if (lost % 2 == 0) {
     for (int i = 0; i < lost / 2; i++) {
-      DrawTexture(empty, (health / 2 + i) * 32 + 10, 0, WHITE);
+      sprite_draw(SPRITE_LAYER_HUD, SPRITE_HEART_EMPTY,
+                  (health / 2 + i) * 32 + 10, 0);
     }
   } else {
     for (int i = 0; i < lost / 2; i++) {
-      DrawTexture(empty, (health / 2 + i + 1) * 32 + 10, 0, WHITE);
+      sprite_draw(SPRITE_LAYER_HUD, SPRITE_HEART_EMPTY,
+                  (health / 2 + i + 1) * 32 + 10, 0);
     }
   }
 }
 
-void player_particle_collision(ParticleSystem *powerup, ParticleSystem *enemy,
-                               ParticleSystem *boss) {
-  // find if particles are above 880px
-  // check if each particle is colliding with charecter
-  // if they are, delete particle and take away one life
-  // if not, do nothing
-  for (int i = 0; i < MAX_PARTICLES; i++) {
-    if (enemy->particles[i].y > 800) {
-
-      Rectangle enemyTmp = (Rectangle){
-          enemy->particles[i].x, enemy->particles[i].y,
-          enemy->particles[i].frameWidth, enemy->particles[i].frameHeight};
-
-      Rectangle sharkTmp = {shark.x, shark.y, shark.frameWidth,
-                            shark.frameHeight};
-      if (CheckCollisionRecs(sharkTmp, enemyTmp) &&
-          enemy->particles[i].isAlive == true) {
-        enemyTmp = (Rectangle){0, 0, 0, 0};
-        enemy->particles[i].isAlive = false;
-        shark.health -= 1;
-      }
-    }
-
-    // player and powerup collision
-    if (powerup->particles[i].y > 800) {
-
-      Rectangle powerupTemp = (Rectangle){
-          powerup->particles[i].x, powerup->particles[i].y,
-          powerup->particles[i].frameWidth, powerup->particles[i].frameHeight};
+// F3 overlay: zone times and submitted geometry for the last frame, and frame
+// time percentiles since the overlay was turned on
+void profile_overlay_draw() {
+  uint64_t p50, p95, p99;
+  profile_percentiles(&p50, &p95, &p99);
+  int y = 50;
+  DrawRectangle(0, y - 5, 230,
+                20 * (PROFILE_ZONE_COUNT + 4 + latencyEnabled + lateLatch) +
+                    10,
+                Fade(BLACK, 0.7f));
+  for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++) {
+    // pattern, update and collision are parts of the simulation
+    int indent =
+        zone >= PROFILE_PATTERN && zone <= PROFILE_COLLISION ? 20 : 0;
+    DrawText(TextFormat("%s %.3f ms", profile_zone_name(zone),
+                        profile_zone_ns(zone) / 1e6),
+             10 + indent, y, 16, RAYWHITE);
+    y += 20;
+  }
+  DrawText(TextFormat("draw calls %d  vertices %d", frameDrawCalls,
+                      frameVertices),
+           10, y, 16, RAYWHITE);
+  y += 20;
+  DrawText(TextFormat("texture batches %d  saved %d",
+                      spriteQueue.sortedBatches,
+                      spriteQueue.unsortedBatches - spriteQueue.sortedBatches),
+           10, y, 16, RAYWHITE);
+  y += 20;
+  DrawText(TextFormat("sfx voices %d of %d", sfx_voices_playing(&sfx),
+                      SFX_MAX_VOICES),
+           10, y, 16, RAYWHITE);
+  y += 20;
+  if (latencyEnabled) {
+    DrawText(TextFormat("input latency p50 <%d  p95 <%d ms",
+                        latency_percentile(&latency, 50),
+                        latency_percentile(&latency, 95)),
+             10, y, 16, RAYWHITE);
+    y += 20;
+  }
+  if (lateLatch) {
+    DrawText(TextFormat("late latch, work budget %.2f of %.2f ms",
+                        pacer_predict(&pacer) / 1e6, frameTargetNs / 1e6),
+             10, y, 16, RAYWHITE);
+    y += 20;
+  }
+  DrawText(TextFormat("p50 %.2f  p95 %.2f  p99 %.2f ms", p50 / 1e6, p95 / 1e6,
+                      p99 / 1e6),
+           10, y, 16, RAYWHITE);
+}
 
-      Rectangle sharkTemp = {shark.x, shark.y, shark.frameWidth,
-                             shark.frameHeight};
-      if (CheckCollisionRecs(sharkTemp, powerupTemp) &&
-          powerup->particles[i].isAlive == true) {
-        powerup->particles[i].isAlive = false;
-        // add player powerup ability
-      }
-    }
+// Runs on raudio's mixing thread at the end of every device callback
+void audio_trace(void *buffer, unsigned int frames) {
+  (void)buffer;
+  static bool named = false;
+  if (!named) {
+    trace_thread_name("audio");
+    named = true;
   }
+  trace_instant("audio mix", frames);
 }
 
-void player_projectile_collision(ParticleSystem *projectile,
-                                 ParticleSystem *powerup, ParticleSystem *enemy,
-                                 ParticleSystem *boss) {
-  for (int i = 0; i < 14; i++) {
-    if (projectile->particles[i].isAlive) {
-      for (int j = 0; j < MAX_PARTICLES; j++) {
-        Rectangle enemyTmp = (Rectangle){
-            enemy->particles[j].x, enemy->particles[j].y,
-            enemy->particles[j].frameWidth, enemy->particles[j].frameHeight};
-
-        Rectangle projectileTmp = {projectile->particles[i].x,
-                                   projectile->particles[i].y,
-                                   projectile->particles[i].frameWidth * 2,
-                                   projectile->particles[i].frameHeight};
-        if (CheckCollisionRecs(projectileTmp, enemyTmp) &&
-            enemy->particles[j].isAlive == true) {
-          enemyTmp = (Rectangle){0, 0, 0, 0};
-          projectile->particles[i].isAlive = false;
-          enemy->particles[j].health -= 1;
-        }
-
-        if (powerup->particles[j].isAlive &&
-            (powerup->particles[j].type & BOX) == BOX) {
-          // Check for box collision
-          Rectangle powerupTmp =
-              (Rectangle){powerup->particles[j].x, powerup->particles[j].y,
-                          powerup->particles[j].frameWidth,
-                          powerup->particles[j].frameHeight};
-          if (CheckCollisionRecs(projectileTmp, powerupTmp)) {
-            powerup->particles[j].health--;
-          }
-        }
-      }
-    }
+// raylib's TRACELOG output, sent through the game's logger
+void raylib_log(int logLevel, const char *text, va_list args) {
+  switch (logLevel) {
+  case LOG_TRACE:
+  case LOG_DEBUG:
+    game_log_vwrite(GAME_LOG_DEBUG, "DEBUG: ", text, args);
+    break;
+  case LOG_INFO:
+    game_log_vwrite(GAME_LOG_INFO, "INFO: ", text, args);
+    break;
+  case LOG_WARNING:
+    game_log_vwrite(GAME_LOG_WARNING, "WARNING: ", text, args);
+    break;
+  case LOG_FATAL:
+    // raylib exits as soon as this returns, so write it out directly
+    log_stop();
+    game_log_vwrite(GAME_LOG_WARNING, "FATAL: ", text, args);
+    break;
+  default:
+    game_log_vwrite(GAME_LOG_WARNING, "ERROR: ", text, args);
+    break;
   }
 }
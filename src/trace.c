@@ -0,0 +1,177 @@
+#include "trace.h"
+#include "log.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  const char *name;
+  uint64_t start;
+  uint64_t end; // 0 for instant events
+  int value;
+} TraceEvent;
+
+// Written only by its thread at head and read only by the flushing thread at
+// tail; the release/acquire pairs hand each event over.
+typedef struct {
+  TraceEvent events[TRACE_RING_SIZE];
+  _Atomic unsigned int head;
+  _Atomic unsigned int tail;
+  _Atomic unsigned int dropped;
+  const char *_Atomic name;
+  // the name last written to the trace file
+  const char *written;
+  int tid;
+} TraceRing;
+
+_Atomic bool traceEnabled = false;
+
+static TraceRing *_Atomic rings[TRACE_MAX_THREADS];
+static _Atomic int ringCount = 0;
+static _Thread_local TraceRing *threadRing = NULL;
+static FILE *traceFile = NULL;
+static uint64_t traceStart;
+static bool firstEvent;
+
+static TraceRing *trace_ring(void) {
+  if (threadRing != NULL) {
+    return threadRing;
+  }
+  // claim a slot only while one is left, so the count never passes the table
+  int index = atomic_load(&ringCount);
+  do {
+    if (index >= TRACE_MAX_THREADS) {
+      return NULL;
+    }
+  } while (!atomic_compare_exchange_weak(&ringCount, &index, index + 1));
+  TraceRing *ring = calloc(1, sizeof(TraceRing));
+  ring->tid = index + 1;
+  atomic_init(&ring->name, "thread");
+  rings[index] = ring;
+  threadRing = ring;
+  return ring;
+}
+
+bool trace_open(const char *path) {
+  traceFile = fopen(path, "w");
+  if (traceFile == NULL) {
+    return false;
+  }
+  // JSON array format; the viewers accept it without the closing bracket, so
+  // a trace cut short by a crash still loads
+  fputs("[", traceFile);
+  firstEvent = true;
+  traceStart = profile_now_ns();
+  traceEnabled = true;
+  return true;
+}
+
+void trace_thread_name(const char *name) {
+  TraceRing *ring = trace_ring();
+  if (ring != NULL) {
+    atomic_store(&ring->name, name);
+  }
+}
+
+static void trace_push(const char *name, uint64_t start, uint64_t end,
+                       int value) {
+  TraceRing *ring = trace_ring();
+  if (ring == NULL) {
+    return;
+  }
+  unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head - tail == TRACE_RING_SIZE) {
+    atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+    return;
+  }
+  ring->events[head % TRACE_RING_SIZE] = (TraceEvent){name, start, end, value};
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void trace_complete(const char *name, uint64_t startNs, uint64_t endNs) {
+  if (trace_enabled()) {
+    trace_push(name, startNs, endNs, 0);
+  }
+}
+
+void trace_instant(const char *name, int value) {
+  if (trace_enabled()) {
+    trace_push(name, profile_now_ns(), 0, value);
+  }
+}
+
+void trace_scope_end(TraceScope *scope) {
+  if (trace_enabled() && scope->start != 0) {
+    trace_push(scope->name, scope->start, profile_now_ns(), 0);
+  }
+}
+
+static void trace_separator(void) {
+  fputs(firstEvent ? "\n" : ",\n", traceFile);
+  firstEvent = false;
+}
+
+void trace_flush(void) {
+  if (traceFile == NULL) {
+    return;
+  }
+  int count = atomic_load(&ringCount);
+  if (count > TRACE_MAX_THREADS) {
+    count = TRACE_MAX_THREADS;
+  }
+  for (int r = 0; r < count; r++) {
+    TraceRing *ring = rings[r];
+    if (ring == NULL) {
+      continue; // registered but not yet published
+    }
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    // once per ring, and again only if the thread is renamed
+    const char *name = atomic_load(&ring->name);
+    if (name != ring->written) {
+      trace_separator();
+      fprintf(traceFile,
+              "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+              "\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+              ring->tid, name);
+      ring->written = name;
+    }
+    for (; tail != head; tail++) {
+      const TraceEvent *e = &ring->events[tail % TRACE_RING_SIZE];
+      // timestamps are microseconds; three decimals keep the nanoseconds
+      double ts = (double)(e->start - traceStart) / 1e3;
+      trace_separator();
+      if (e->end != 0) {
+        fprintf(traceFile,
+                "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                "\"ts\":%.3f,\"dur\":%.3f}",
+                e->name, ring->tid, ts, (double)(e->end - e->start) / 1e3);
+      } else {
+        fprintf(traceFile,
+                "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,"
+                "\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%d}}",
+                e->name, ring->tid, ts, e->value);
+      }
+    }
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    unsigned int dropped = atomic_exchange(&ring->dropped, 0);
+    if (dropped > 0) {
+      game_log(GAME_LOG_WARNING,
+               "TRACE: %s dropped %u events, flush more often\n", name,
+               dropped);
+    }
+  }
+  fflush(traceFile);
+}
+
+void trace_close(void) {
+  if (traceFile == NULL) {
+    return;
+  }
+  traceEnabled = false;
+  trace_flush();
+  fputs("\n]\n", traceFile);
+  fclose(traceFile);
+  traceFile = NULL;
+}
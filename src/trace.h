@@ -0,0 +1,41 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Event recorder for chrome://tracing and Perfetto. Each thread that records
+// gets its own single-producer ring, so recording never takes a lock; the
+// main thread drains all rings into the trace file when trace_flush is called.
+// Event names are not copied and must be string literals.
+
+#include "profile.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Events held per thread between flushes, a few minutes of frames
+#define TRACE_RING_SIZE (1 << 18)
+#define TRACE_MAX_THREADS 8
+
+bool trace_open(const char *path);
+// Name the calling thread's track in the trace viewer
+void trace_thread_name(const char *name);
+void trace_complete(const char *name, uint64_t startNs, uint64_t endNs);
+void trace_instant(const char *name, int value);
+// Write out everything recorded so far. Main thread only.
+void trace_flush(void);
+void trace_close(void);
+
+typedef struct {
+  const char *name;
+  uint64_t start;
+} TraceScope;
+
+void trace_scope_end(TraceScope *scope);
+
+// Record the rest of the enclosing block as one event
+#define TRACE_SCOPE_NAME(line) traceScope##line
+#define TRACE_SCOPE_LINE(name, line)                                           \
+  TraceScope TRACE_SCOPE_NAME(line)                                            \
+      __attribute__((cleanup(trace_scope_end))) = {                            \
+          name, trace_enabled() ? profile_now_ns() : 0}
+#define TRACE_SCOPE(name) TRACE_SCOPE_LINE(name, __LINE__)
+
+#endif
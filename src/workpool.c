@@ -0,0 +1,117 @@
+#include "workpool.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// The indices still owned by one worker. The owner takes from the front and
+// thieves take from the back; the lock is only contended while stealing.
+typedef struct {
+  pthread_mutex_t lock;
+  int next;
+  int end;
+} WorkRange;
+
+typedef struct {
+  WorkRange *ranges;
+  int threads;
+  WorkFn fn;
+  void *user;
+} WorkPool;
+
+typedef struct {
+  WorkPool *pool;
+  int worker;
+} WorkerArgs;
+
+static bool work_pop(WorkRange *range, int *index) {
+  pthread_mutex_lock(&range->lock);
+  bool found = range->next < range->end;
+  if (found) {
+    *index = range->next++;
+  }
+  pthread_mutex_unlock(&range->lock);
+  return found;
+}
+
+// Move the back half of the fullest other range into this worker's range
+static bool work_steal(WorkPool *pool, int worker) {
+  int victim = -1;
+  int most = 0;
+  for (int i = 0; i < pool->threads; i++) {
+    if (i == worker) {
+      continue;
+    }
+    // the owner moves next under the lock, so the peek takes it too
+    WorkRange *range = &pool->ranges[i];
+    pthread_mutex_lock(&range->lock);
+    int left = range->end - range->next;
+    pthread_mutex_unlock(&range->lock);
+    if (left > most) {
+      most = left;
+      victim = i;
+    }
+  }
+  if (victim < 0) {
+    return false;
+  }
+  WorkRange *from = &pool->ranges[victim];
+  pthread_mutex_lock(&from->lock);
+  int left = from->end - from->next;
+  int take = left - left / 2;
+  int start = from->end - take;
+  if (take > 0) {
+    from->end = start;
+  }
+  pthread_mutex_unlock(&from->lock);
+  if (take <= 0) {
+    return true; // lost the race, look again
+  }
+  WorkRange *own = &pool->ranges[worker];
+  pthread_mutex_lock(&own->lock);
+  own->next = start;
+  own->end = start + take;
+  pthread_mutex_unlock(&own->lock);
+  return true;
+}
+
+static void *work_thread(void *arg) {
+  WorkerArgs *args = arg;
+  WorkPool *pool = args->pool;
+  int index;
+  do {
+    while (work_pop(&pool->ranges[args->worker], &index)) {
+      pool->fn(index, args->worker, pool->user);
+    }
+  } while (work_steal(pool, args->worker));
+  return NULL;
+}
+
+void work_pool_run(int threads, int count, WorkFn fn, void *user) {
+  if (threads < 1) {
+    threads = 1;
+  }
+  WorkPool pool = {malloc(threads * sizeof(WorkRange)), threads, fn, user};
+  pthread_t *ids = malloc(threads * sizeof(pthread_t));
+  WorkerArgs *args = malloc(threads * sizeof(WorkerArgs));
+  for (int i = 0; i < threads; i++) {
+    pthread_mutex_init(&pool.ranges[i].lock, NULL);
+    pool.ranges[i].next = (int)((long)count * i / threads);
+    pool.ranges[i].end = (int)((long)count * (i + 1) / threads);
+  }
+  // worker 0 is the calling thread
+  for (int i = 1; i < threads; i++) {
+    args[i] = (WorkerArgs){&pool, i};
+    pthread_create(&ids[i], NULL, work_thread, &args[i]);
+  }
+  args[0] = (WorkerArgs){&pool, 0};
+  work_thread(&args[0]);
+  for (int i = 1; i < threads; i++) {
+    pthread_join(ids[i], NULL);
+  }
+  for (int i = 0; i < threads; i++) {
+    pthread_mutex_destroy(&pool.ranges[i].lock);
+  }
+  free(pool.ranges);
+  free(ids);
+  free(args);
+}
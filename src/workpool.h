@@ -0,0 +1,13 @@
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+// Runs fn(index, worker, user) for every index in [0, count) on a fixed set
+// of threads. Each worker starts with an even slice of the range and, once it
+// runs dry, steals half of what is left in the fullest other slice, so long
+// and short jobs even out without a shared queue on the hot path.
+
+typedef void (*WorkFn)(int index, int worker, void *user);
+
+void work_pool_run(int threads, int count, WorkFn fn, void *user);
+
+#endif